@@ -33,15 +33,13 @@ void Clock::Tick() {
   }
 }
 
-void Initialize() {
+void Initialize(ContextSettings const &settings) {
   if (!glfwInit()) {
     throw Exceptions::GraphicsException("Failed to initialize GLFW");
     return;
   }
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  SetContextSettings(settings);
   glfwWindowHint(GLFW_DOUBLEBUFFER, GL_TRUE);
 
   glfwSetJoystickCallback(JoystickCallback);
@@ -53,6 +51,8 @@ void Terminate() {
   GLFW_INITIALIZED = false;
 
   if (GLAD_INITIALIZED) {
+    Sampler::ClearCache();
+    Compute::StagingPool::Clear();
     gladLoaderUnloadGL();
     GLAD_INITIALIZED = false;
   }
@@ -3,6 +3,22 @@
 namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
 
+static void SetAttributePointer(Uint const &index, AttributeData const &attr) {
+  glEnableVertexAttribArray(index);
+  void const *offset = reinterpret_cast<void const *>(attr.offset);
+  if (attr.type != AttributeType::FLOAT &&
+      attr.type != AttributeType::HALF_FLOAT && !attr.normalized) {
+    // Integer attributes reach the shader as int or uint.
+    glVertexAttribIPointer(index, attr.size, (GLenum)attr.type, attr.stride,
+                           offset);
+    return;
+  }
+
+  glVertexAttribPointer(index, attr.size, (GLenum)attr.type,
+                        attr.normalized ? GL_TRUE : GL_FALSE, attr.stride,
+                        offset);
+}
+
 Vec<Float> const &BufferDataConstructor::GetVertexData() const {
   if (!mConstructed) {
     throw Exceptions::BufferError("Data not constructed.");
@@ -102,11 +118,11 @@ void Buffer::LoadData(Vec<Float> const &raw,
       throw Exceptions::BufferError("Attribute location not found.");
     }
     Uint index = locations.at(name);
-    glEnableVertexAttribArray(index);
-    glVertexAttribPointer(index, attr.size, GL_FLOAT, GL_FALSE, attr.stride,
-                          reinterpret_cast<void const *>(attr.offset));
-    mAttributes.insert(
-        {name, {mBuffers.size(), index, attr.size, attr.stride, attr.offset}});
+    SetAttributePointer(index, attr);
+    AttributeData bound = attr;
+    bound.vboIndex = mBuffers.size();
+    bound.index = index;
+    mAttributes.insert({name, bound});
   }
   this->Unbind();
   glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -131,17 +147,69 @@ void Buffer::LoadData(BufferDataConstructor const &bdc,
     }
     AttributeData const &attr = attributes.at(name);
     Uint index = locations.at(name);
-    glEnableVertexAttribArray(index);
-    glVertexAttribPointer(index, attr.size, GL_FLOAT, GL_FALSE, attr.stride,
-                          reinterpret_cast<void const *>(attr.offset));
-    mAttributes.insert(
-        {name, {mBuffers.size(), index, attr.size, attr.stride, attr.offset}});
+    SetAttributePointer(index, attr);
+    AttributeData bound = attr;
+    bound.vboIndex = mBuffers.size();
+    bound.index = index;
+    mAttributes.insert({name, bound});
   }
   this->Unbind();
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   mBuffers.push_back(buffer);
 }
 
+void Buffer::AllocateData(Ulong const &size,
+                          Map<Str, AttributeData> const &attrs,
+                          Map<Str, Uint> const &locations,
+                          BufferUsage const &usage) {
+  this->Bind();
+  GLObject buffer = GLObject();
+  glGenBuffers(1, buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ARRAY_BUFFER, size, nullptr, (GLenum)usage);
+
+  for (auto &[name, attr] : attrs) {
+    if (locations.find(name) == locations.end()) {
+      throw Exceptions::BufferError("Attribute location not found.");
+    }
+    Uint index = locations.at(name);
+    SetAttributePointer(index, attr);
+    AttributeData bound = attr;
+    bound.vboIndex = mBuffers.size();
+    bound.index = index;
+    mAttributes.insert({name, bound});
+  }
+  this->Unbind();
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  mBuffers.push_back(buffer);
+}
+
+void Buffer::ReallocateData(Ulong const &vboIndex, Ulong const &size,
+                            BufferUsage const &usage) {
+  if (vboIndex >= mBuffers.size()) {
+    throw Exceptions::BufferError("Vertex buffer index out of range.");
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, mBuffers[vboIndex]);
+  glBufferData(GL_ARRAY_BUFFER, size, nullptr, (GLenum)usage);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Buffer::ReloadBytes(void const *data, Ulong const &offset,
+                         Ulong const &size, Ulong const &vboIndex) {
+  if (vboIndex >= mBuffers.size()) {
+    throw Exceptions::BufferError("Vertex buffer index out of range.");
+  }
+
+  if (size == 0) {
+    return;
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, mBuffers[vboIndex]);
+  glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void Buffer::ReloadData(AttributeData const &target,
                         BufferDataConstructor const &bdc) {
   Vec<Float> data = bdc.GetVertexData();
@@ -165,10 +233,12 @@ void Buffer::ReloadData(AttributeData const &target,
 }
 
 void Buffer::LoadIndices(Vec<Uint> const &indices) {
-  mLoadedIndices = true;
   mIndexCount = indices.size();
   this->Bind();
-  glGenBuffers(1, mIBO);
+  if (!mLoadedIndices) {
+    glGenBuffers(1, mIBO);
+    mLoadedIndices = true;
+  }
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIBO);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(Uint),
                indices.data(), GL_STATIC_DRAW);
@@ -215,6 +285,23 @@ void Buffer::Draw(DrawMode const &mode, Ulong const &count) const {
   this->Unbind();
 }
 
+void Buffer::DrawInstances(DrawMode const &mode, Ulong const &vertexCount,
+                           Ulong const &instanceCount,
+                           Ulong const &firstInstance) const {
+  if (mBuffers.size() == 0) {
+    throw Exceptions::BufferError("No buffers attached to buffer.");
+  }
+
+  this->Bind();
+  if (firstInstance == 0) {
+    glDrawArraysInstanced((GLenum)mode, 0, vertexCount, instanceCount);
+  } else {
+    glDrawArraysInstancedBaseInstance((GLenum)mode, 0, vertexCount,
+                                      instanceCount, firstInstance);
+  }
+  this->Unbind();
+}
+
 UniformBuffer::~UniformBuffer() {
   if (mUBO.Count() <= 1) {
     glDeleteBuffers(1, mUBO);
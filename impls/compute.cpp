@@ -1,5 +1,7 @@
 #include "../includes/compute.hpp"
+#include "../includes/device.hpp"
 #include "../includes/exceptions.hpp"
+#include "../includes/programcache.hpp"
 
 namespace TerreateGraphics::Compute {
 Str GetShaderLog(Uint const &id) {
@@ -189,12 +191,44 @@ void ComputeKernel::BindWriteImage(Str const &name,
                      0, GL_WRITE_ONLY, GL_RGBA32F);
 }
 
+void ComputeKernel::BindWriteImage(Str const &name, Texture const &texture,
+                                   TextureChannelType const &format) const {
+  this->SetInt(name, this->GetLocation(name));
+  glBindImageTexture(this->GetLocation(name), texture.GetGLIndex(), 0, GL_TRUE,
+                     0, GL_WRITE_ONLY, (GLenum)format);
+}
+
+void ComputeKernel::BindWriteImage(Str const &name, CubeTexture const &texture,
+                                   Uint const &level) const {
+  this->SetInt(name, this->GetLocation(name));
+  glBindImageTexture(this->GetLocation(name), texture.GetGLIndex(), level,
+                     GL_TRUE, 0, GL_WRITE_ONLY, (GLenum)texture.GetFormat());
+}
+
 void ComputeKernel::Compile() {
+  // State of an earlier compile must not decide how this one links.
+  mBinaryLoaded = false;
+  mCacheKey = 0u;
   if (mKernelSource == "") {
     throw Exceptions::ShaderError("Compute kernel source is empty");
     return;
   }
 
+  if (!Core::GetDeviceCaps().compute) {
+    throw Exceptions::ShaderError(
+        "Compute shaders are not supported by current context");
+    return;
+  }
+
+  if (ProgramCache::IsEnabled()) {
+    mCacheKey = ProgramCache::Hash({mKernelSource});
+    if (ProgramCache::Load(mKernelID, mCacheKey)) {
+      mBinaryLoaded = true;
+      mCompiled = true;
+      return;
+    }
+  }
+
   ID kernelID = 0;
   kernelID = glCreateShader(GL_COMPUTE_SHADER);
   char const *kernelSource = mKernelSource.c_str();
@@ -214,8 +248,17 @@ void ComputeKernel::Link() {
     return;
   }
 
-  glLinkProgram(mKernelID);
-  CheckLinkStatus(mKernelID);
+  // Programs loaded from the cache are already linked.
+  if (!mBinaryLoaded) {
+    if (mCacheKey != 0) {
+      ProgramCache::Prepare(mKernelID);
+    }
+    glLinkProgram(mKernelID);
+    CheckLinkStatus(mKernelID);
+    if (mCacheKey != 0) {
+      ProgramCache::Save(mKernelID, mCacheKey);
+    }
+  }
   mLinked = true;
 }
 
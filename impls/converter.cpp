@@ -1,11 +1,178 @@
 #include "../includes/converter.hpp"
+#include "../includes/device.hpp"
 #include "../includes/exceptions.hpp"
 #include "../includes/shader.hpp"
 
+#include <algorithm>
+
 namespace TerreateGraphics::Compute {
 using namespace TerreateGraphics::Defines;
 using namespace TerreateGraphics::Compute;
 
+struct StagingTexture {
+  GLObject texture;
+  Uint width;
+  Uint height;
+  Uint layers; // 0 for 2D textures
+  TextureChannelType format;
+  Ulong lastUse;
+};
+
+static Uint const sMinStagingSize = 64;
+static Vec<StagingTexture> sStagingTextures;
+static Size sStagingBudget = 64ull << 20;
+static Ulong sStagingClock = 0u;
+
+static Size GetStagingByteSize(StagingTexture const &staging) {
+  return (Size)staging.width * staging.height * std::max(staging.layers, 1u) *
+         Texture::GetTexelSize(staging.format);
+}
+
+static Uint GetBucketSize(Uint const &size, Uint const &minSize) {
+  Uint bucket = minSize;
+  while (bucket < size) {
+    bucket <<= 1;
+  }
+  return bucket;
+}
+
+static GLenum GetPixelFormat(Uint const &channels) {
+  switch (channels) {
+  case 1:
+    return GL_RED;
+  case 2:
+    return GL_RG;
+  case 3:
+    return GL_RGB;
+  case 4:
+    return GL_RGBA;
+  default:
+    throw Exceptions::TextureError("Invalid number of channels.");
+  }
+}
+
+static GLenum GetIntegerPixelFormat(Uint const &channels) {
+  switch (channels) {
+  case 1:
+    return GL_RED_INTEGER;
+  case 2:
+    return GL_RG_INTEGER;
+  case 3:
+    return GL_RGB_INTEGER;
+  case 4:
+    return GL_RGBA_INTEGER;
+  default:
+    throw Exceptions::TextureError("Invalid number of channels.");
+  }
+}
+
+static void UploadPixels(GLObject const &texture, Uint const &width,
+                         Uint const &height, GLenum const &format,
+                         GLenum const &type, void const *pixels) {
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, pixels);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+static GLObject AcquireStaging(Uint const &width, Uint const &height,
+                               Uint const &layers,
+                               TextureChannelType const &format) {
+  Uint bucketWidth = GetBucketSize(width, sMinStagingSize);
+  Uint bucketHeight = GetBucketSize(height, sMinStagingSize);
+  Uint bucketLayers = 0;
+  if (layers != 0) {
+    bucketLayers =
+        std::min(GetBucketSize(layers, 1u), Texture::GetMaxLayers());
+  }
+
+  for (auto &staging : sStagingTextures) {
+    if (staging.width == bucketWidth && staging.height == bucketHeight &&
+        staging.format == format &&
+        (staging.layers == 0) == (bucketLayers == 0) &&
+        staging.layers >= bucketLayers) {
+      staging.lastUse = ++sStagingClock;
+      return staging.texture;
+    }
+  }
+
+  GLenum target = layers == 0 ? GL_TEXTURE_2D : GL_TEXTURE_2D_ARRAY;
+  GLObject texture = GLObject();
+  glGenTextures(1, texture);
+  glBindTexture(target, texture);
+  if (layers == 0) {
+    glTexStorage2D(target, 1, (GLenum)format, bucketWidth, bucketHeight);
+  } else {
+    glTexStorage3D(target, 1, (GLenum)format, bucketWidth, bucketHeight,
+                   bucketLayers);
+  }
+  // Integer textures are incomplete with linear filtering.
+  GLint filter =
+      format == TextureChannelType::RGBA8UI ? GL_NEAREST : GL_LINEAR;
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(target, 0);
+  sStagingTextures.push_back({texture, bucketWidth, bucketHeight, bucketLayers,
+                              format, ++sStagingClock});
+  return texture;
+}
+
+namespace StagingPool {
+GLObject Acquire(Uint const &width, Uint const &height,
+                 TextureChannelType const &format) {
+  return AcquireStaging(width, height, 0, format);
+}
+
+GLObject AcquireArray(Uint const &width, Uint const &height,
+                      Uint const &layers, TextureChannelType const &format) {
+  return AcquireStaging(width, height, std::max(layers, 1u), format);
+}
+
+Size GetByteSize() {
+  Size size = 0;
+  for (auto const &staging : sStagingTextures) {
+    size += GetStagingByteSize(staging);
+  }
+  return size;
+}
+
+Size const &GetBudget() { return sStagingBudget; }
+
+void SetBudget(Size const &budget) {
+  sStagingBudget = budget;
+  Trim();
+}
+
+void Trim() {
+  Size size = GetByteSize();
+  if (size <= sStagingBudget) {
+    return;
+  }
+
+  // Most recently acquired first, so the least recent are popped.
+  std::sort(sStagingTextures.begin(), sStagingTextures.end(),
+            [](StagingTexture const &a, StagingTexture const &b) {
+              return a.lastUse > b.lastUse;
+            });
+  while (size > sStagingBudget && !sStagingTextures.empty()) {
+    StagingTexture &staging = sStagingTextures.back();
+    size -= GetStagingByteSize(staging);
+    glDeleteTextures(1, staging.texture);
+    sStagingTextures.pop_back();
+  }
+}
+
+void Clear() {
+  for (auto &staging : sStagingTextures) {
+    glDeleteTextures(1, staging.texture);
+  }
+  sStagingTextures.clear();
+}
+} // namespace StagingPool
+
 Str const ImageConverter::sKernelSource =
     "#version 430\n"
     "layout(local_size_x=" +
@@ -15,133 +182,493 @@ Str const ImageConverter::sKernelSource =
     R"(
 uniform sampler2D inputTexture;
 layout(rgba32f) uniform image2DArray outputTextures;
-uniform vec2 textureSize;
 uniform vec2 inputSize;
 uniform vec2 outputSize;
 uniform int layer;
 void main() {
   ivec3 id = ivec3(gl_GlobalInvocationID);
-  vec2 scale = inputSize / textureSize;
-  vec2 inputUV = vec2(id.xy) / outputSize;
-  vec4 inputColor = texture(inputTexture, inputUV * scale);
+  if (id.x >= int(outputSize.x) || id.y >= int(outputSize.y)) {
+    return;
+  }
+  // Staging texture is bucketed, so only its top left corner holds image.
+  vec2 scale = inputSize / vec2(textureSize(inputTexture, 0));
+  vec2 inputUV = (vec2(id.xy) + 0.5) / outputSize;
+  vec4 inputColor = textureLod(inputTexture, inputUV * scale, 0.0);
   imageStore(outputTextures, ivec3(id.xy, layer), inputColor);
 }
     )";
 
-void ImageConverter::CreateInputTexture() {
-  Uint size = Texture::GetMaxTextureSize() / 2;
-  mKernel.SetVec2("textureSize", {size, size});
+Str const ImageConverter::sBatchKernelSource =
+    "#version 430\n"
+    "layout(local_size_x=" +
+    std::to_string(ImageConverter::sKernelInputSize) +
+    ", local_size_y=" + std::to_string(ImageConverter::sKernelInputSize) +
+    ") in;" +
+    R"(
+struct LayerInfo {
+  vec2 inputSize;
+  int layer;
+  int padding;
+};
+layout(std430) readonly buffer LayerInfos {
+  LayerInfo infos[];
+};
+uniform sampler2DArray inputTextures;
+layout(rgba32f) uniform image2DArray outputTextures;
+uniform vec2 outputSize;
+void main() {
+  ivec3 id = ivec3(gl_GlobalInvocationID);
+  if (id.x >= int(outputSize.x) || id.y >= int(outputSize.y)) {
+    return;
+  }
+  LayerInfo info = infos[id.z];
+  vec2 scale = info.inputSize / vec2(textureSize(inputTextures, 0).xy);
+  vec2 inputUV = (vec2(id.xy) + 0.5) / outputSize;
+  vec4 inputColor =
+      textureLod(inputTextures, vec3(inputUV * scale, float(id.z)), 0.0);
+  imageStore(outputTextures, ivec3(id.xy, info.layer), inputColor);
+}
+    )";
+
+Str const ImageConverter::sResampleKernelSource =
+    "#define TILE_SIZE " + std::to_string(ImageConverter::sResampleTileSize) +
+    "\nlayout(local_size_x=" +
+    std::to_string(ImageConverter::sResampleGroupSize) + ") in;" +
+    R"(
+layout(std430) readonly buffer FilterFirsts {
+  int firsts[];
+};
+layout(std430) readonly buffer FilterWeights {
+  float weights[];
+};
+uniform vec2 inputSize;
+uniform vec2 outputSize;
+uniform int taps;
+shared vec4 tile[TILE_SIZE];
+void main() {
+  int inputLength = AlongLength(ivec2(inputSize));
+  int outputLength = AlongLength(ivec2(outputSize));
+  int groupSize = int(gl_WorkGroupSize.x);
+  int across = int(gl_WorkGroupID.y);
+  int groupBegin = int(gl_WorkGroupID.x) * groupSize;
+  int groupEnd = min(groupBegin + groupSize, outputLength) - 1;
+  int along = groupBegin + int(gl_LocalInvocationID.x);
+
+  // Source texels of the whole group are staged in shared memory unless the
+  // footprint is too wide, e.g. on extreme downscales.
+  int spanBegin = firsts[groupBegin];
+  int span = firsts[groupEnd] + taps - spanBegin;
+  bool tiled = span <= TILE_SIZE;
+  if (tiled) {
+    for (int i = int(gl_LocalInvocationID.x); i < span; i += groupSize) {
+      int source = clamp(spanBegin + i, 0, inputLength - 1);
+      tile[i] = Fetch(ToCoord(source, across));
+    }
+  }
+  barrier();
+  if (along > groupEnd) {
+    return;
+  }
+
+  // Summation order matches ImageOps::Resample. Additions and
+  // multiplications are correctly rounded and precise keeps the compiler
+  // from fusing them into fma, so CPU and GPU results are bit identical.
+  int first = firsts[along];
+  precise vec4 sum = vec4(0.0);
+  for (int k = 0; k < taps; ++k) {
+    vec4 texel;
+    if (tiled) {
+      texel = tile[first + k - spanBegin];
+    } else {
+      int source = clamp(first + k, 0, inputLength - 1);
+      texel = Fetch(ToCoord(source, across));
+    }
+    sum += weights[along * taps + k] * texel;
+  }
+  Store(ToCoord(along, across), sum);
+}
+    )";
+
+// Input bytes are fetched as integers. The 1/255 scale is folded into the
+// horizontal weights, like ImageOps::Resample does.
+Str const ImageConverter::sHorizontalKernelSource =
+    "#version 430\n" + Str(R"(
+uniform usampler2D inputTexture;
+uniform int channels;
+layout(rgba32f) uniform writeonly image2D outputImage;
+ivec2 ToCoord(int along, int across) { return ivec2(along, across); }
+int AlongLength(ivec2 size) { return size.x; }
+vec4 Fetch(ivec2 coord) {
+  vec4 texel = vec4(texelFetch(inputTexture, coord, 0));
+  // Images without alpha are opaque.
+  if (channels < 4) {
+    texel.a = 255.0;
+  }
+  return texel;
+}
+void Store(ivec2 coord, vec4 color) { imageStore(outputImage, coord, color); }
+)") + ImageConverter::sResampleKernelSource;
+
+static Str const sVerticalKernelHeader = R"(
+uniform sampler2D inputTexture;
+uniform int layer;
+ivec2 ToCoord(int along, int across) { return ivec2(across, along); }
+int AlongLength(ivec2 size) { return size.y; }
+vec4 Fetch(ivec2 coord) { return texelFetch(inputTexture, coord, 0); }
+vec4 Quantize(vec4 color) {
+  // Same rounding as ImageOps::Resample.
+  precise vec4 quantized = floor(clamp(color, 0.0, 1.0) * 255.0 + 0.5);
+  return quantized;
+}
+)";
+
+Str const ImageConverter::sVerticalKernelSource =
+    "#version 430\n" + sVerticalKernelHeader + R"(
+layout(rgba32f) uniform writeonly image2DArray outputTextures;
+void Store(ivec2 coord, vec4 color) {
+  imageStore(outputTextures, ivec3(coord, layer), Quantize(color) / 255.0);
+}
+)" + ImageConverter::sResampleKernelSource;
+
+// RGBA8 storage is written as RGBA8UI, so the quantized bytes land unchanged
+// instead of going through a float to unorm conversion.
+Str const ImageConverter::sVerticalByteKernelSource =
+    "#version 430\n" + sVerticalKernelHeader + R"(
+layout(rgba8ui) uniform writeonly uimage2DArray outputTextures;
+void Store(ivec2 coord, vec4 color) {
+  imageStore(outputTextures, ivec3(coord, layer), uvec4(Quantize(color)));
+}
+)" + ImageConverter::sResampleKernelSource;
+
+Str const EquirectangularConverter::sProjectionKernelSource =
+    "#version 430\n"
+    "layout(local_size_x=" +
+    std::to_string(EquirectangularConverter::sKernelInputSize) +
+    ", local_size_y=" +
+    std::to_string(EquirectangularConverter::sKernelInputSize) + ") in;" +
+    R"(
+const float PI = 3.14159265358979;
+uniform sampler2D inputTexture;
+writeonly uniform imageCube outputCube;
+uniform int faceSize;
+vec3 FaceDirection(int face, vec2 st) {
+  switch (face) {
+  case 0: return vec3(1.0, -st.y, -st.x);
+  case 1: return vec3(-1.0, -st.y, st.x);
+  case 2: return vec3(st.x, 1.0, st.y);
+  case 3: return vec3(st.x, -1.0, -st.y);
+  case 4: return vec3(st.x, -st.y, 1.0);
+  default: return vec3(-st.x, -st.y, -1.0);
+  }
+}
+void main() {
+  ivec3 id = ivec3(gl_GlobalInvocationID);
+  if (id.x >= faceSize || id.y >= faceSize) {
+    return;
+  }
+  vec2 st = (vec2(id.xy) + 0.5) / float(faceSize) * 2.0 - 1.0;
+  vec3 direction = normalize(FaceDirection(id.z, st));
+  vec2 inputUV = vec2(atan(direction.z, direction.x) / (2.0 * PI) + 0.5,
+                      acos(clamp(direction.y, -1.0, 1.0)) / PI);
+  imageStore(outputCube, id, textureLod(inputTexture, inputUV, 0.0));
+}
+    )";
+
+Str const EquirectangularConverter::sPrefilterKernelSource =
+    "#version 430\n"
+    "layout(local_size_x=" +
+    std::to_string(EquirectangularConverter::sKernelInputSize) +
+    ", local_size_y=" +
+    std::to_string(EquirectangularConverter::sKernelInputSize) + ") in;" +
+    R"(
+uniform samplerCube inputCube;
+writeonly uniform imageCube outputCube;
+uniform int faceSize;
+uniform float sourceLevel;
+vec3 FaceDirection(int face, vec2 st) {
+  switch (face) {
+  case 0: return vec3(1.0, -st.y, -st.x);
+  case 1: return vec3(-1.0, -st.y, st.x);
+  case 2: return vec3(st.x, 1.0, st.y);
+  case 3: return vec3(st.x, -1.0, -st.y);
+  case 4: return vec3(st.x, -st.y, 1.0);
+  default: return vec3(-st.x, -st.y, -1.0);
+  }
+}
+void main() {
+  ivec3 id = ivec3(gl_GlobalInvocationID);
+  if (id.x >= faceSize || id.y >= faceSize) {
+    return;
+  }
+  // Texel center of this level lies on the corner of four source texels, so
+  // a bilinear fetch of the source level is their box average.
+  vec2 st = (vec2(id.xy) + 0.5) / float(faceSize) * 2.0 - 1.0;
+  vec3 direction = FaceDirection(id.z, st);
+  imageStore(outputCube, id, textureLod(inputCube, direction, sourceLevel));
+}
+    )";
+
+void EquirectangularConverter::CreateInputTexture(Uint const &width,
+                                                  Uint const &height) {
+  if (mInputWidth == width && mInputHeight == height) {
+    return;
+  }
+
+  if (mInputWidth != 0) {
+    glDeleteTextures(1, mInputTexture);
+  }
+
   glGenTextures(1, mInputTexture);
   glBindTexture(GL_TEXTURE_2D, mInputTexture);
-  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, size, size);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, width, height);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glBindTexture(GL_TEXTURE_2D, 0);
+  mInputWidth = width;
+  mInputHeight = height;
 }
 
-ImageConverter::ImageConverter() {
-  /* mKernel.AddKernelSource(sKernelSource); */
-  mKernel.AddKernelSource(sKernelSource);
-  mKernel.Compile();
-  mKernel.Link();
+void EquirectangularConverter::Project(CubeTexture &storage) {
+  Uint size = storage.GetWidth();
+  Uint dispatch = (size + (sKernelInputSize - 1)) / sKernelInputSize;
 
+  mProjectionKernel.BindWriteImage("outputCube", storage, 0);
   Shader::ActivateTexture(TextureTargets::TEX_0);
-  mKernel.SetInt("inputTexture", 0);
-  this->CreateInputTexture();
+  mProjectionKernel.SetInt("inputTexture", 0);
+  mProjectionKernel.SetInt("faceSize", size);
+  Sampler::Unbind();
+  glBindTexture(GL_TEXTURE_2D, mInputTexture);
+  mProjectionKernel.Dispatch(dispatch, dispatch, 6);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // Each level is built from the previous one, so levels are dispatched in
+  // order with a barrier in between. The sampler is fixed, because a
+  // non-mipmap filter set by the caller would ignore the source level.
+  mPrefilterKernel.SetInt("inputCube", 0);
+  storage.Bind(TextureTargets::TEX_0,
+               Sampler::Get({FilterType::LINEAR_MIPMAP_NEAREST,
+                             FilterType::LINEAR, WrappingType::CLAMP_TO_EDGE,
+                             WrappingType::CLAMP_TO_EDGE,
+                             WrappingType::CLAMP_TO_EDGE}));
+  for (Uint level = 1; level < storage.GetLevels(); ++level) {
+    Uint levelSize = std::max(size >> level, 1u);
+    dispatch = (levelSize + (sKernelInputSize - 1)) / sKernelInputSize;
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    mPrefilterKernel.BindWriteImage("outputCube", storage, level);
+    mPrefilterKernel.SetInt("faceSize", levelSize);
+    mPrefilterKernel.SetFloat("sourceLevel", level - 1);
+    mPrefilterKernel.Dispatch(dispatch, dispatch, 6);
+  }
+  storage.Unbind();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
 }
 
-ImageConverter::~ImageConverter() {
-  if (mInputTexture.Count() <= 1) {
+EquirectangularConverter::EquirectangularConverter() {
+  mProjectionKernel.AddKernelSource(sProjectionKernelSource);
+  mProjectionKernel.Compile();
+  mProjectionKernel.Link();
+
+  mPrefilterKernel.AddKernelSource(sPrefilterKernelSource);
+  mPrefilterKernel.Compile();
+  mPrefilterKernel.Link();
+}
+
+EquirectangularConverter::~EquirectangularConverter() {
+  if (mInputWidth != 0 && mInputTexture.Count() <= 1) {
     glDeleteTextures(1, mInputTexture);
     mInputTexture.Delete();
   }
 }
 
-void ImageConverter::Convert(Str const &name, Uint const &width,
-                             Uint const &height, Uint const &channels,
-                             Ubyte const *pixels, Texture &storage) {
+void EquirectangularConverter::Convert(Uint const &width, Uint const &height,
+                                       Uint const &channels,
+                                       Float const *pixels,
+                                       CubeTexture &storage) {
+  this->CreateInputTexture(width, height);
+  UploadPixels(mInputTexture, width, height, GetPixelFormat(channels),
+               GL_FLOAT, (void const *)pixels);
+  this->Project(storage);
+}
+
+void EquirectangularConverter::Convert(Uint const &width, Uint const &height,
+                                       Uint const &channels,
+                                       Ubyte const *pixels,
+                                       CubeTexture &storage) {
+  this->CreateInputTexture(width, height);
+  UploadPixels(mInputTexture, width, height, GetPixelFormat(channels),
+               GL_UNSIGNED_BYTE, (void const *)pixels);
+  this->Project(storage);
+}
+
+void ImageConverter::DispatchBatch(ConvertRequest const *requests,
+                                   Uint const &count, Uint const &width,
+                                   Uint const &height, Texture &storage) {
+  GLObject input = StagingPool::AcquireArray(width, height, count,
+                                             TextureChannelType::RGBA8);
+  Vec<LayerInfo> infos(count);
+  Shader::ActivateTexture(TextureTargets::TEX_0);
+  Sampler::Unbind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, input);
+  for (Uint i = 0; i < count; ++i) {
+    ConvertRequest const &request = requests[i];
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, request.width,
+                    request.height, 1, GetPixelFormat(request.channels),
+                    GL_UNSIGNED_BYTE, (void const *)request.pixels);
+    infos[i] = {{(Float)request.width, (Float)request.height},
+                (Int)request.layer,
+                0};
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  mLayerInfos.LoadData(infos, BufferUsage::STREAM_DRAW);
+
   Uint dispatchX =
       (storage.GetWidth() + (sKernelInputSize - 1)) / sKernelInputSize;
   Uint dispatchY =
       (storage.GetHeight() + (sKernelInputSize - 1)) / sKernelInputSize;
+  mBatchKernel.BindImage("outputTextures", storage);
+  mLayerInfos.Bind(mBatchKernel, "LayerInfos");
+  mBatchKernel.SetInt("inputTextures", 0);
+  mBatchKernel.SetVec2("outputSize",
+                       vec2(storage.GetWidth(), storage.GetHeight()));
+  mBatchKernel.Dispatch(dispatchX, dispatchY, count);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
-  Uint format;
-  switch (channels) {
-  case 1:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    format = GL_RED;
-    break;
-  case 2:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
-    format = GL_RG;
-    break;
-  case 3:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 3);
-    format = GL_RGB;
-    break;
-  case 4:
-    format = GL_RGBA;
-    break;
-  default:
-    throw Exceptions::TextureError("Invalid number of channels.");
+  for (Uint i = 0; i < count; ++i) {
+    storage.AddBinding(requests[i].name, requests[i].layer);
   }
+}
 
-  glBindTexture(GL_TEXTURE_2D, mInputTexture);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format,
-                  GL_UNSIGNED_BYTE, (void const *)pixels);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+void ImageConverter::Resample(GLObject const &input, Uint const &width,
+                              Uint const &height, Uint const &channels,
+                              Uint const &index, Texture &storage) {
+  Uint outputWidth = storage.GetWidth();
+  Uint outputHeight = storage.GetHeight();
+  ResampleWeights horizontal = ImageOps::ComputeResampleWeights(
+      width, outputWidth, mFilter, 1.0 / 255.0);
+  ResampleWeights vertical =
+      ImageOps::ComputeResampleWeights(height, outputHeight, mFilter);
+  GLObject intermediate = StagingPool::Acquire(outputWidth, height,
+                                               TextureChannelType::RGBA32F);
+
+  Shader::ActivateTexture(TextureTargets::TEX_0);
+  Sampler::Unbind();
+
+  mFilterFirsts.LoadData(horizontal.firsts, BufferUsage::STREAM_DRAW);
+  mFilterWeights.LoadData(horizontal.weights, BufferUsage::STREAM_DRAW);
+  mFilterFirsts.Bind(mHorizontalKernel, "FilterFirsts");
+  mFilterWeights.Bind(mHorizontalKernel, "FilterWeights");
+  mHorizontalKernel.BindImage("outputImage", intermediate);
+  mHorizontalKernel.SetInt("inputTexture", 0);
+  mHorizontalKernel.SetInt("channels", channels);
+  mHorizontalKernel.SetVec2("inputSize", vec2(width, height));
+  mHorizontalKernel.SetVec2("outputSize", vec2(outputWidth, height));
+  mHorizontalKernel.SetInt("taps", horizontal.taps);
+  glBindTexture(GL_TEXTURE_2D, input);
+  mHorizontalKernel.Dispatch(
+      (outputWidth + (sResampleGroupSize - 1)) / sResampleGroupSize, height);
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  mFilterFirsts.LoadData(vertical.firsts, BufferUsage::STREAM_DRAW);
+  mFilterWeights.LoadData(vertical.weights, BufferUsage::STREAM_DRAW);
+  Bool bytes = storage.GetFormat() == TextureChannelType::RGBA8;
+  ComputeKernel &kernel = bytes ? mVerticalByteKernel : mVerticalKernel;
+  mFilterFirsts.Bind(kernel, "FilterFirsts");
+  mFilterWeights.Bind(kernel, "FilterWeights");
+  if (bytes) {
+    kernel.BindWriteImage("outputTextures", storage,
+                          TextureChannelType::RGBA8UI);
+  } else {
+    kernel.BindImage("outputTextures", storage);
+  }
+  kernel.SetInt("inputTexture", 0);
+  kernel.SetVec2("inputSize", vec2(outputWidth, height));
+  kernel.SetVec2("outputSize", vec2(outputWidth, outputHeight));
+  kernel.SetInt("taps", vertical.taps);
+  kernel.SetInt("layer", index);
+  glBindTexture(GL_TEXTURE_2D, intermediate);
+  kernel.Dispatch(
+      (outputHeight + (sResampleGroupSize - 1)) / sResampleGroupSize,
+      outputWidth);
   glBindTexture(GL_TEXTURE_2D, 0);
+}
 
-  mKernel.BindImage("outputTextures", storage);
+ImageConverter::ImageConverter() {
+  mCompute = Core::GetDeviceCaps().tier != FeatureTier::LEGACY;
+  if (!mCompute) {
+    return;
+  }
+
+  mKernel.AddKernelSource(sKernelSource);
+  mKernel.Compile();
+  mKernel.Link();
+
+  mHorizontalKernel.AddKernelSource(sHorizontalKernelSource);
+  mHorizontalKernel.Compile();
+  mHorizontalKernel.Link();
+
+  mVerticalKernel.AddKernelSource(sVerticalKernelSource);
+  mVerticalKernel.Compile();
+  mVerticalKernel.Link();
+
+  mVerticalByteKernel.AddKernelSource(sVerticalByteKernelSource);
+  mVerticalByteKernel.Compile();
+  mVerticalByteKernel.Link();
+
+  mBatchKernel.AddKernelSource(sBatchKernelSource);
+  mBatchKernel.Compile();
+  mBatchKernel.Link();
 
   Shader::ActivateTexture(TextureTargets::TEX_0);
   mKernel.SetInt("inputTexture", 0);
-  mKernel.SetVec2("inputSize", vec2(width, height));
-  mKernel.SetVec2("outputSize", vec2(storage.GetWidth(), storage.GetHeight()));
-  mKernel.SetInt("layer", storage.GetCurrentLayer());
-  glBindTexture(GL_TEXTURE_2D, mInputTexture);
-  mKernel.Dispatch(dispatchX, dispatchY, 1);
-  glBindTexture(GL_TEXTURE_2D, 0);
-  storage.AddBinding(name);
+}
+
+void ImageConverter::Convert(Str const &name, Uint const &width,
+                             Uint const &height, Uint const &channels,
+                             Ubyte const *pixels, Texture &storage) {
+  this->Convert(name, storage.GetCurrentLayer(), width, height, channels,
+                pixels, storage);
 }
 
 void ImageConverter::Convert(Str const &name, Uint const &index,
                              Uint const &width, Uint const &height,
                              Uint const &channels, Ubyte const *pixels,
                              Texture &storage) {
+  storage.Reserve(index + 1);
+  if (!mCompute) {
+    TextureData source;
+    source.width = width;
+    source.height = height;
+    source.channels = channels;
+    source.pixels.assign(pixels, pixels + (Size)width * height * channels);
+    storage.LoadDataAt(name, 0, 0, index,
+                       ImageOps::Resample(source, storage.GetWidth(),
+                                          storage.GetHeight(), mFilter));
+    return;
+  }
+
   Uint dispatchX =
       (storage.GetWidth() + (sKernelInputSize - 1)) / sKernelInputSize;
   Uint dispatchY =
       (storage.GetHeight() + (sKernelInputSize - 1)) / sKernelInputSize;
 
-  Uint format;
-  switch (channels) {
-  case 1:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    format = GL_RED;
-    break;
-  case 2:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
-    format = GL_RG;
-    break;
-  case 3:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 3);
-    format = GL_RGB;
-    break;
-  case 4:
-    format = GL_RGBA;
-    break;
-  default:
-    throw Exceptions::TextureError("Invalid number of channels.");
+  if (mFilter != ResampleFilter::BILINEAR) {
+    GLObject input =
+        StagingPool::Acquire(width, height, TextureChannelType::RGBA8UI);
+    UploadPixels(input, width, height, GetIntegerPixelFormat(channels),
+                 GL_UNSIGNED_BYTE, (void const *)pixels);
+    this->Resample(input, width, height, channels, index, storage);
+    storage.AddBinding(name, index);
+    StagingPool::Trim();
+    return;
   }
 
-  glBindTexture(GL_TEXTURE_2D, mInputTexture);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format,
-                  GL_UNSIGNED_BYTE, (void const *)pixels);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  GLObject input =
+      StagingPool::Acquire(width, height, TextureChannelType::RGBA8);
+  UploadPixels(input, width, height, GetPixelFormat(channels),
+               GL_UNSIGNED_BYTE, (void const *)pixels);
 
   mKernel.BindImage("outputTextures", storage);
 
@@ -150,9 +677,63 @@ void ImageConverter::Convert(Str const &name, Uint const &index,
   mKernel.SetVec2("inputSize", vec2(width, height));
   mKernel.SetVec2("outputSize", vec2(storage.GetWidth(), storage.GetHeight()));
   mKernel.SetInt("layer", index);
-  glBindTexture(GL_TEXTURE_2D, mInputTexture);
+  Sampler::Unbind();
+  glBindTexture(GL_TEXTURE_2D, input);
   mKernel.Dispatch(dispatchX, dispatchY, 1);
   glBindTexture(GL_TEXTURE_2D, 0);
   storage.AddBinding(name, index);
+  StagingPool::Trim();
+}
+
+void ImageConverter::ConvertBatch(Vec<ConvertRequest> const &requests,
+                                  Texture &storage) {
+  if (requests.empty()) {
+    return;
+  }
+
+  if (mFilter != ResampleFilter::BILINEAR || !mCompute) {
+    // Separable filters run two passes per image, and LEGACY contexts
+    // resample each image on CPU.
+    for (auto const &request : requests) {
+      this->Convert(request.name, request.layer, request.width,
+                    request.height, request.channels, request.pixels,
+                    storage);
+    }
+    return;
+  }
+
+  Uint lastLayer = 0;
+  for (auto const &request : requests) {
+    lastLayer = std::max(lastLayer, request.layer);
+  }
+  storage.Reserve(lastLayer + 1);
+
+  // Requests are packed into staging array chunks bounded by layer limit and
+  // staging memory budget. Each chunk is one upload pass and one dispatch.
+  Uint maxLayers = Texture::GetMaxLayers();
+  Uint begin = 0;
+  while (begin < requests.size()) {
+    Uint width = 0;
+    Uint height = 0;
+    Uint end = begin;
+    while (end < requests.size() && end - begin < maxLayers) {
+      Uint chunkWidth = std::max(width, requests[end].width);
+      Uint chunkHeight = std::max(height, requests[end].height);
+      Size bytes = (Size)GetBucketSize(chunkWidth, sMinStagingSize) *
+                   GetBucketSize(chunkHeight, sMinStagingSize) *
+                   GetBucketSize(end - begin + 1, 1u) * 4;
+      if (end > begin && bytes > sBatchByteBudget) {
+        break;
+      }
+      width = chunkWidth;
+      height = chunkHeight;
+      ++end;
+    }
+
+    this->DispatchBatch(requests.data() + begin, end - begin, width, height,
+                        storage);
+    begin = end;
+  }
+  StagingPool::Trim();
 }
 } // namespace TerreateGraphics::Compute
@@ -0,0 +1,140 @@
+#include "../includes/device.hpp"
+#include "../includes/exceptions.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+static ContextSettings sContextSettings = ContextSettings();
+static DeviceCaps sDeviceCaps = DeviceCaps();
+
+static Uint GetInteger(GLenum const &name) {
+  GLint value = 0;
+  glGetIntegerv(name, &value);
+  return value > 0 ? value : 0;
+}
+
+static Str GetString(GLenum const &name) {
+  GLubyte const *value = glGetString(name);
+  return value == nullptr ? "" : Str((char const *)value);
+}
+
+static void SetContextHints(Uint const &major, Uint const &minor,
+                            ContextSettings const &settings) {
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+  // Profiles only exist from OpenGL 3.2.
+  if (major > 3 || (major == 3 && minor >= 2)) {
+    glfwWindowHint(GLFW_OPENGL_PROFILE, (int)settings.profile);
+  } else {
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
+  }
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, settings.forwardCompatible);
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, settings.debug);
+}
+
+ContextSettings const &GetContextSettings() { return sContextSettings; }
+
+void SetContextSettings(ContextSettings const &settings) {
+  sContextSettings = settings;
+}
+
+GLFWwindow *CreateContextWindow(Uint const &width, Uint const &height,
+                                Str const &title) {
+  Vec<Pair<Uint>> versions = {{sContextSettings.major, sContextSettings.minor}};
+  for (auto const &version : sContextSettings.fallbacks) {
+    if (version < versions.front()) {
+      versions.push_back(version);
+    }
+  }
+
+  for (auto const &[major, minor] : versions) {
+    SetContextHints(major, minor, sContextSettings);
+    GLFWwindow *window =
+        glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+    if (window != nullptr) {
+      return window;
+    }
+  }
+
+  throw Exceptions::GraphicsException(
+      "Failed to create window with any OpenGL context version.");
+}
+
+void LoadDeviceCaps() {
+  DeviceCaps caps;
+  caps.major = GetInteger(GL_MAJOR_VERSION);
+  caps.minor = GetInteger(GL_MINOR_VERSION);
+  caps.vendor = GetString(GL_VENDOR);
+  caps.renderer = GetString(GL_RENDERER);
+  caps.version = GetString(GL_VERSION);
+  caps.shadingLanguageVersion = GetString(GL_SHADING_LANGUAGE_VERSION);
+
+  Uint numExtensions = GetInteger(GL_NUM_EXTENSIONS);
+  for (Uint i = 0; i < numExtensions; ++i) {
+    GLubyte const *name = glGetStringi(GL_EXTENSIONS, i);
+    if (name != nullptr) {
+      caps.extensions.insert(Str((char const *)name));
+    }
+  }
+
+  caps.compute =
+      caps.IsVersion(4, 3) || caps.HasExtension("GL_ARB_compute_shader");
+  caps.textureStorage =
+      caps.IsVersion(4, 2) || caps.HasExtension("GL_ARB_texture_storage");
+  caps.copyImage =
+      caps.IsVersion(4, 3) || caps.HasExtension("GL_ARB_copy_image");
+  caps.bufferStorage =
+      caps.IsVersion(4, 4) || caps.HasExtension("GL_ARB_buffer_storage");
+  caps.directStateAccess =
+      caps.IsVersion(4, 5) || caps.HasExtension("GL_ARB_direct_state_access");
+  caps.multiDrawIndirect =
+      caps.IsVersion(4, 3) || caps.HasExtension("GL_ARB_multi_draw_indirect");
+  caps.parallelShaderCompile =
+      caps.HasExtension("GL_KHR_parallel_shader_compile") ||
+      caps.HasExtension("GL_ARB_parallel_shader_compile");
+  caps.programBinary =
+      (caps.IsVersion(4, 1) ||
+       caps.HasExtension("GL_ARB_get_program_binary")) &&
+      GetInteger(GL_NUM_PROGRAM_BINARY_FORMATS) > 0;
+  caps.anisotropy =
+      caps.IsVersion(4, 6) ||
+      caps.HasExtension("GL_ARB_texture_filter_anisotropic") ||
+      caps.HasExtension("GL_EXT_texture_filter_anisotropic");
+
+  caps.maxTextureSize = GetInteger(GL_MAX_TEXTURE_SIZE);
+  caps.maxArrayTextureLayers = GetInteger(GL_MAX_ARRAY_TEXTURE_LAYERS);
+  caps.maxCubeMapTextureSize = GetInteger(GL_MAX_CUBE_MAP_TEXTURE_SIZE);
+  caps.maxTextureImageUnits = GetInteger(GL_MAX_TEXTURE_IMAGE_UNITS);
+  caps.maxCombinedTextureImageUnits =
+      GetInteger(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS);
+  caps.maxUniformBlockSize = GetInteger(GL_MAX_UNIFORM_BLOCK_SIZE);
+  if (caps.anisotropy) {
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &caps.maxAnisotropy);
+  }
+  if (caps.compute) {
+    caps.maxImageUnits = GetInteger(GL_MAX_IMAGE_UNITS);
+    caps.maxShaderStorageBlockSize =
+        GetInteger(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
+    caps.maxComputeSharedMemorySize =
+        GetInteger(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE);
+    caps.maxComputeWorkGroupInvocations =
+        GetInteger(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS);
+    for (Uint i = 0; i < 3; ++i) {
+      GLint count = 0;
+      glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, i, &count);
+      caps.maxComputeWorkGroupCount[i] = count;
+    }
+  }
+
+  if (caps.compute && caps.copyImage && caps.textureStorage) {
+    caps.tier = FeatureTier::COMPUTE;
+    if (caps.bufferStorage && caps.directStateAccess) {
+      caps.tier = FeatureTier::MODERN;
+    }
+  }
+
+  sDeviceCaps = caps;
+}
+
+DeviceCaps const &GetDeviceCaps() { return sDeviceCaps; }
+} // namespace TerreateGraphics::Core
@@ -1,12 +1,798 @@
 #include "../includes/exceptions.hpp"
 #include "../includes/font.hpp"
+#include "../includes/unicode.hpp"
+
+#include FT_MODULE_H
+#include FT_SIZES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
 
+// Empty texels between packed glyphs, so linear filtering never bleeds into
+// a neighbour.
+static Uint const sGlyphPadding = 1u;
+
+// Read only memory mapping of a whole file. Empty when the file is missing.
+class MappedFile final {
+private:
+  Ubyte const *mData = nullptr;
+  Size mSize = 0u;
+#if defined(_WIN32)
+  HANDLE mFile = INVALID_HANDLE_VALUE;
+  HANDLE mMapping = nullptr;
+#endif
+
+public:
+  explicit MappedFile(Str const &path);
+  ~MappedFile();
+  MappedFile(MappedFile const &) = delete;
+  MappedFile &operator=(MappedFile const &) = delete;
+
+  Ubyte const *GetData() const { return mData; }
+  Size const &GetSize() const { return mSize; }
+};
+
+#if defined(_WIN32)
+MappedFile::MappedFile(Str const &path) {
+  mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    return;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0) {
+    return;
+  }
+
+  mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mMapping == nullptr) {
+    return;
+  }
+
+  mData = (Ubyte const *)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+  if (mData != nullptr) {
+    mSize = size.QuadPart;
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (mData != nullptr) {
+    UnmapViewOfFile(mData);
+  }
+  if (mMapping != nullptr) {
+    CloseHandle(mMapping);
+  }
+  if (mFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(mFile);
+  }
+}
+#else
+MappedFile::MappedFile(Str const &path) {
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return;
+  }
+
+  struct stat info;
+  if (fstat(file, &info) == 0 && info.st_size > 0) {
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (data != MAP_FAILED) {
+      mData = (Ubyte const *)data;
+      mSize = info.st_size;
+    }
+  }
+  close(file);
+}
+
+MappedFile::~MappedFile() {
+  if (mData != nullptr) {
+    munmap((void *)mData, mSize);
+  }
+}
+#endif
+
+// On-disk cache layout: one header, then glyph records in packing order,
+// each followed by width * height pixels. Records are only ever appended,
+// so replaying them through the packer reproduces the atlas exactly.
+struct GlyphCacheHeader {
+  Ubyte magic[4] = {'T', 'G', 'F', 'C'};
+  Uint version = 1u;
+  Ulong fontHash = 0u;
+  Uint size = 0u;
+  Uint mode = 0u;
+  Uint spread = 0u;
+  Uint atlasSize = 0u;
+  Uint padding = 0u;
+  Uint reserved = 0u;
+};
+
+struct GlyphCacheRecord {
+  Uint codepoint = 0u;
+  Uint width = 0u;
+  Uint height = 0u;
+  Int bearingX = 0;
+  Int bearingY = 0;
+  Uint x = 0u;
+  Uint y = 0u;
+  Uint layer = 0u;
+  Long advance = 0;
+};
+
+static GlyphCacheHeader MakeCacheHeader(Ulong const &fontHash,
+                                        Uint const &size,
+                                        FontRenderMode const &mode,
+                                        Uint const &spread,
+                                        Uint const &atlasSize) {
+  GlyphCacheHeader header;
+  header.fontHash = fontHash;
+  header.size = size;
+  header.mode = (Uint)mode;
+  header.spread = mode == FontRenderMode::SDF ? spread : 0u;
+  header.atlasSize = atlasSize;
+  header.padding = sGlyphPadding;
+  return header;
+}
+
+// Process-wide FreeType state. Faces stay open while a font uses them.
+static Mutex sFaceMutex;
+static Shared<FT_Library> sLibrary = nullptr;
+static Map<Str, std::weak_ptr<FontFace>> sFaceCache;
+
+struct GlyphRasterizer {
+  FT_Library library = nullptr;
+  Vec<FT_Face> faces = Vec<FT_Face>(); // primary face, then fallbacks
+  Uint spread = 0u;
+};
+
+// State shared with background rasterization tasks. Tasks hold a reference,
+// so a font can be reloaded or destroyed while glyphs are in flight.
+struct GlyphJobs {
+  Vec<Shared<MappedFile>> files;
+  Uint size = 0u;
+  FontRenderMode mode = FontRenderMode::BITMAP;
+  Atomic<Uint> spread = 8u;
+  Mutex mutex;
+  Vec<GlyphRasterizer> rasterizers;
+  Vec<GlyphBitmap> ready;
+  Vec<Uint> failed;
+
+  ~GlyphJobs() {
+    for (auto &rasterizer : rasterizers) {
+      // Faces are released with their library.
+      FT_Done_FreeType(rasterizer.library);
+    }
+  }
+
+  GlyphRasterizer Acquire();
+  void Release(GlyphRasterizer const &rasterizer);
+  void Rasterize(Uint const &codepoint);
+};
+
+static void SetLibrarySpread(FT_Library library, Uint const &spread) {
+  // Both the outline and the bitmap based renderer read this property.
+  FT_Int value = spread;
+  FT_Property_Set(library, "sdf", "spread", &value);
+  FT_Property_Set(library, "bsdf", "spread", &value);
+}
+
+// First face mapping the codepoint, or the primary face for tofu.
+static FT_Face FindFace(Vec<FT_Face> const &faces, Uint const &codepoint) {
+  for (FT_Face const &face : faces) {
+    if (FT_Get_Char_Index(face, codepoint) != 0) {
+      return face;
+    }
+  }
+  return faces.front();
+}
+
+static GlyphBitmap RasterizeGlyph(FT_Face face, Uint const &codepoint,
+                                  FontRenderMode const &mode) {
+  if (mode == FontRenderMode::SDF) {
+    if (FT_Load_Char(face, codepoint, FT_LOAD_DEFAULT) ||
+        FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF)) {
+      throw Exceptions::FontError("Failed to render distance field.");
+    }
+  } else if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) {
+    throw Exceptions::FontError("Failed to load character.");
+  }
+
+  FT_Bitmap const &bitmap = face->glyph->bitmap;
+  GlyphBitmap glyph;
+  glyph.codepoint = codepoint;
+  glyph.size = {bitmap.width, bitmap.rows};
+  glyph.bearing = {face->glyph->bitmap_left, face->glyph->bitmap_top};
+  glyph.advance = face->glyph->advance.x;
+  glyph.pixels.resize((Size)bitmap.width * bitmap.rows);
+  for (Uint row = 0; row < bitmap.rows; ++row) {
+    std::memcpy(glyph.pixels.data() + (Size)row * bitmap.width,
+                bitmap.buffer + (Long)row * bitmap.pitch, bitmap.width);
+  }
+  return glyph;
+}
+
+GlyphRasterizer GlyphJobs::Acquire() {
+  GlyphRasterizer rasterizer;
+  {
+    LockGuard<Mutex> lock(mutex);
+    if (!rasterizers.empty()) {
+      rasterizer = rasterizers.back();
+      rasterizers.pop_back();
+    }
+  }
+
+  if (rasterizer.library == nullptr) {
+    if (FT_Init_FreeType(&rasterizer.library)) {
+      throw Exceptions::FontError("Failed to initialize FreeType.");
+    }
+    for (auto const &file : files) {
+      FT_Face face = nullptr;
+      if (FT_New_Memory_Face(rasterizer.library, file->GetData(),
+                             (FT_Long)file->GetSize(), 0, &face)) {
+        FT_Done_FreeType(rasterizer.library);
+        throw Exceptions::FontError("Failed to load font.");
+      }
+      FT_Set_Pixel_Sizes(face, 0, size);
+      rasterizer.faces.push_back(face);
+    }
+  }
+
+  Uint current = spread;
+  if (mode == FontRenderMode::SDF && rasterizer.spread != current) {
+    SetLibrarySpread(rasterizer.library, current);
+    rasterizer.spread = current;
+  }
+  return rasterizer;
+}
+
+void GlyphJobs::Release(GlyphRasterizer const &rasterizer) {
+  LockGuard<Mutex> lock(mutex);
+  rasterizers.push_back(rasterizer);
+}
+
+void GlyphJobs::Rasterize(Uint const &codepoint) {
+  GlyphRasterizer rasterizer;
+  try {
+    rasterizer = this->Acquire();
+    GlyphBitmap glyph = RasterizeGlyph(
+        FindFace(rasterizer.faces, codepoint), codepoint, mode);
+    this->Release(rasterizer);
+    LockGuard<Mutex> lock(mutex);
+    ready.push_back(std::move(glyph));
+  } catch (Exceptions::FontError const &) {
+    if (rasterizer.library != nullptr) {
+      this->Release(rasterizer);
+    }
+    LockGuard<Mutex> lock(mutex);
+    failed.push_back(codepoint);
+  }
+}
+
+FontFace::FontFace(Shared<FT_Library> const &library, Str const &path)
+    : mPath(path), mLibrary(library) {
+  mFile = Shared<MappedFile>(new MappedFile(path));
+  if (mFile->GetData() == nullptr ||
+      FT_New_Memory_Face(*mLibrary, mFile->GetData(),
+                         (FT_Long)mFile->GetSize(), 0, &mFace)) {
+    mFace = nullptr;
+    throw Exceptions::FontError("Failed to load font.");
+    return;
+  }
+}
+
+FontFace::~FontFace() {
+  // Sizes are released with the face, before the mapping goes away.
+  if (mFace != nullptr) {
+    FT_Done_Face(mFace);
+  }
+}
+
+Ulong FontFace::GetHash() {
+  if (mHash != 0) {
+    return mHash;
+  }
+
+  Ulong hash = 14695981039346656037ull;
+  for (Size i = 0; i < mFile->GetSize(); ++i) {
+    hash ^= mFile->GetData()[i];
+    hash *= 1099511628211ull;
+  }
+  mHash = hash;
+  return mHash;
+}
+
+FT_Face FontFace::Activate(Uint const &pixels) {
+  auto it = mSizes.find(pixels);
+  if (it != mSizes.end()) {
+    FT_Activate_Size(it->second);
+    return mFace;
+  }
+
+  FT_Size size = nullptr;
+  if (FT_New_Size(mFace, &size)) {
+    throw Exceptions::FontError("Failed to create font size.");
+  }
+  FT_Activate_Size(size);
+  FT_Set_Pixel_Sizes(mFace, 0, pixels);
+  mSizes.insert({pixels, size});
+  return mFace;
+}
+
+Shared<FontFace> FontFace::Get(Str const &path) {
+  LockGuard<Mutex> lock(sFaceMutex);
+  if (sLibrary == nullptr) {
+    FT_Library library = nullptr;
+    if (FT_Init_FreeType(&library)) {
+      throw Exceptions::FontError("Failed to initialize FreeType.");
+    }
+    // Faces hold the library too, so it outlives fonts destroyed at exit.
+    sLibrary = Shared<FT_Library>(new FT_Library(library),
+                                  [](FT_Library *library) {
+                                    FT_Done_FreeType(*library);
+                                    delete library;
+                                  });
+  }
+
+  std::error_code error;
+  Str key = std::filesystem::weakly_canonical(path, error).string();
+  if (error) {
+    key = path;
+  }
+
+  Shared<FontFace> face = sFaceCache[key].lock();
+  if (face == nullptr) {
+    face = Shared<FontFace>(new FontFace(sLibrary, path));
+    sFaceCache[key] = face;
+  }
+  return face;
+}
+
+Size FontFace::GetLoadedCount() {
+  LockGuard<Mutex> lock(sFaceMutex);
+  for (auto it = sFaceCache.begin(); it != sFaceCache.end();) {
+    if (it->second.expired()) {
+      it = sFaceCache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return sFaceCache.size();
+}
+
+SkylinePacker::SkylinePacker(Uint const &width, Uint const &height)
+    : mWidth(width), mHeight(height) {
+  this->Clear();
+}
+
+Bool SkylinePacker::Fit(Size const &index, Uint const &width,
+                        Uint const &height, Uint &y) const {
+  Uint x = mSkyline[index].x;
+  if (x + width > mWidth) {
+    return false;
+  }
+
+  y = 0;
+  Uint covered = 0;
+  for (Size i = index; covered < width; ++i) {
+    y = std::max(y, mSkyline[i].y);
+    if (y + height > mHeight) {
+      return false;
+    }
+    covered += mSkyline[i].width;
+  }
+  return true;
+}
+
+Float SkylinePacker::GetOccupancy() const {
+  if (mWidth == 0 || mHeight == 0) {
+    return 0.0f;
+  }
+  return (Float)mUsedArea / ((Size)mWidth * mHeight);
+}
+
+Bool SkylinePacker::Pack(Uint const &width, Uint const &height,
+                         Pair<Uint> &position) {
+  if (width == 0 || height == 0) {
+    position = {0, 0};
+    return true;
+  }
+
+  Size best = mSkyline.size();
+  Uint bestTop = mHeight + 1;
+  Uint bestWidth = mWidth + 1;
+  Uint bestY = 0;
+  for (Size i = 0; i < mSkyline.size(); ++i) {
+    Uint y = 0;
+    if (!this->Fit(i, width, height, y)) {
+      continue;
+    }
+    Uint top = y + height;
+    if (top < bestTop || (top == bestTop && mSkyline[i].width < bestWidth)) {
+      best = i;
+      bestTop = top;
+      bestWidth = mSkyline[i].width;
+      bestY = y;
+    }
+  }
+
+  if (best == mSkyline.size()) {
+    return false;
+  }
+
+  Uint x = mSkyline[best].x;
+  mSkyline.insert(mSkyline.begin() + best, {x, bestY + height, width});
+
+  // Trim segments now covered by the new one.
+  Uint right = x + width;
+  for (Size i = best + 1; i < mSkyline.size();) {
+    if (mSkyline[i].x >= right) {
+      break;
+    }
+    Uint overlap = right - mSkyline[i].x;
+    if (mSkyline[i].width <= overlap) {
+      mSkyline.erase(mSkyline.begin() + i);
+      continue;
+    }
+    mSkyline[i].x += overlap;
+    mSkyline[i].width -= overlap;
+    break;
+  }
+
+  // Merge neighbours at the same height.
+  for (Size i = 0; i + 1 < mSkyline.size();) {
+    if (mSkyline[i].y == mSkyline[i + 1].y) {
+      mSkyline[i].width += mSkyline[i + 1].width;
+      mSkyline.erase(mSkyline.begin() + i + 1);
+      continue;
+    }
+    ++i;
+  }
+
+  mUsedArea += (Size)width * height;
+  position = {x, bestY};
+  return true;
+}
+
+void SkylinePacker::Clear() {
+  mSkyline.clear();
+  mSkyline.push_back({0, 0, mWidth});
+  mUsedArea = 0;
+}
+
+Uint const GlyphTable::sDirectSize;
+Uint const GlyphTable::sEmpty;
+Uint const GlyphTable::sTombstone;
+
+Size GlyphTable::Probe(Uint const &codepoint) const {
+  if (mSlots.empty()) {
+    return 0;
+  }
+
+  Size mask = mSlots.size() - 1;
+  for (Size i = GlyphTable::Hash(codepoint) & mask;; i = (i + 1) & mask) {
+    Slot const &slot = mSlots[i];
+    if (slot.index == sEmpty) {
+      return mSlots.size();
+    }
+    if (slot.codepoint == codepoint && slot.index != sTombstone) {
+      return i;
+    }
+  }
+}
+
+void GlyphTable::Rehash(Size const &capacity) {
+  // Rebuilding also drops tombstones left by Erase.
+  mSlots.assign(capacity, {0u, sEmpty});
+  mOccupied = 0;
+  Size mask = capacity - 1;
+  for (Uint index = 0; index < mGlyphs.size(); ++index) {
+    Uint codepoint = mCodepoints[index];
+    if (codepoint < sDirectSize) {
+      continue;
+    }
+    Size i = GlyphTable::Hash(codepoint) & mask;
+    while (mSlots[i].index != sEmpty) {
+      i = (i + 1) & mask;
+    }
+    mSlots[i] = {codepoint, index};
+    ++mOccupied;
+  }
+}
+
+Bool GlyphTable::Insert(Uint const &codepoint, CharacterData const &glyph,
+                        Uint const &use) {
+  if (this->Locate(codepoint) != sEmpty) {
+    return false;
+  }
+
+  Uint index = mGlyphs.size();
+  mGlyphs.push_back(glyph);
+  mCodepoints.push_back(codepoint);
+  mUses.push_back(use);
+  if (codepoint < sDirectSize) {
+    mDirect[codepoint] = index;
+    return true;
+  }
+
+  ++mHashed;
+  // Probes stay short below half load, counting tombstones.
+  if ((mOccupied + 1) * 2 > mSlots.size()) {
+    Size capacity = 16;
+    while (mHashed * 4 > capacity) {
+      capacity <<= 1;
+    }
+    this->Rehash(capacity);
+    return true;
+  }
+
+  Size mask = mSlots.size() - 1;
+  Size i = GlyphTable::Hash(codepoint) & mask;
+  while (mSlots[i].index != sEmpty && mSlots[i].index != sTombstone) {
+    i = (i + 1) & mask;
+  }
+  if (mSlots[i].index == sEmpty) {
+    ++mOccupied;
+  }
+  mSlots[i] = {codepoint, index};
+  return true;
+}
+
+Bool GlyphTable::Erase(Uint const &codepoint) {
+  Uint index = sEmpty;
+  if (codepoint < sDirectSize) {
+    index = mDirect[codepoint];
+    mDirect[codepoint] = sEmpty;
+  } else {
+    Size slot = this->Probe(codepoint);
+    if (slot != mSlots.size()) {
+      index = mSlots[slot].index;
+      mSlots[slot].index = sTombstone;
+      --mHashed;
+    }
+  }
+
+  if (index == sEmpty) {
+    return false;
+  }
+
+  // Moving the last record keeps storage dense for sequential scans.
+  Uint last = mGlyphs.size() - 1;
+  if (index != last) {
+    Uint moved = mCodepoints[last];
+    mGlyphs[index] = mGlyphs[last];
+    mCodepoints[index] = moved;
+    mUses[index] = mUses[last];
+    if (moved < sDirectSize) {
+      mDirect[moved] = index;
+    } else {
+      mSlots[this->Probe(moved)].index = index;
+    }
+  }
+  mGlyphs.pop_back();
+  mCodepoints.pop_back();
+  mUses.pop_back();
+  return true;
+}
+
+void GlyphTable::Clear() {
+  mGlyphs.clear();
+  mCodepoints.clear();
+  mUses.clear();
+  std::fill(mDirect.begin(), mDirect.end(), sEmpty);
+  mSlots.clear();
+  mOccupied = 0;
+  mHashed = 0;
+}
+
 void Font::InitializeTexture() {
-  Uint size = Texture::GetMaxTextureSize() / 2;
-  mTexture = Texture(size / 4, size / 4, 16);
+  // Size the atlas so the expected glyphs fit at one em square each. Most
+  // glyphs are smaller than the em square, which leaves headroom.
+  Uint cell = mSize + sGlyphPadding;
+  if (mRenderMode == FontRenderMode::SDF) {
+    cell += 2 * mSpread;
+  }
+  Size area = (Size)cell * cell * std::max(mExpectedGlyphs, 1u);
+  Uint maxSize = Texture::GetMaxTextureSize();
+  Uint size = 64;
+  while (((Size)size * size < area || size < cell) && size < maxSize) {
+    size <<= 1;
+  }
+  size = std::min(size, maxSize);
+
+  mTexture = Texture(size, size, 1, TextureChannelType::R8);
+  mTexture.SetWrapping(WrappingType::CLAMP_TO_EDGE,
+                       WrappingType::CLAMP_TO_EDGE);
+  mPackers = {SkylinePacker(size, size)};
+}
+
+void Font::ResetAtlas() {
+  this->InitializeTexture();
+  mGlyphs.Clear();
+  this->LoadDummyCharacter();
+  ++mGeneration;
+}
+
+void Font::ResetJobs() {
+  // Glyphs still in flight for the previous faces land in the old jobs.
+  mPending.clear();
+  mJobs = Shared<GlyphJobs>(new GlyphJobs());
+  mJobs->files = {mFace->GetFile()};
+  for (auto const &face : mFallbacks) {
+    mJobs->files.push_back(face->GetFile());
+  }
+  mJobs->size = mSize;
+  mJobs->mode = mRenderMode;
+  mJobs->spread = mSpread;
+}
+
+void Font::ActivateFaces() const {
+  // Faces and the library are shared with fonts of other sizes and spreads.
+  mFace->Activate(mSize);
+  for (auto const &face : mFallbacks) {
+    face->Activate(mSize);
+  }
+  if (mRenderMode == FontRenderMode::SDF) {
+    SetLibrarySpread(mFace->GetLibrary(), mSpread);
+  }
+}
+
+FT_Face Font::SelectFace(Uint const &codepoint) const {
+  FT_Face primary = mFace->GetFace();
+  if (mFallbacks.empty() || FT_Get_Char_Index(primary, codepoint) != 0) {
+    return primary;
+  }
+
+  for (auto const &face : mFallbacks) {
+    if (FT_Get_Char_Index(face->GetFace(), codepoint) != 0) {
+      return face->GetFace();
+    }
+  }
+  return primary;
+}
+
+Bool Font::ReplayCache() {
+  GlyphCacheHeader header = MakeCacheHeader(mFontHash, mSize, mRenderMode,
+                                            mSpread, mTexture.GetWidth());
+
+  MappedFile file(mCachePath);
+  Ubyte const *data = file.GetData();
+  if (file.GetSize() < sizeof(header) ||
+      std::memcmp(data, &header, sizeof(header)) != 0) {
+    return false;
+  }
+
+  Float tw = mTexture.GetWidth();
+  Float th = mTexture.GetHeight();
+  Vec<TextureRegion> regions;
+  Size offset = sizeof(header);
+  while (offset + sizeof(GlyphCacheRecord) <= file.GetSize()) {
+    GlyphCacheRecord record;
+    std::memcpy(&record, data + offset, sizeof(record));
+    Size pixels = (Size)record.width * record.height;
+    if (offset + sizeof(record) + pixels > file.GetSize()) {
+      break; // Torn append. SaveCache truncates it.
+    }
+
+    Pair<Uint> position = {0, 0};
+    Uint layer = 0;
+    try {
+      layer = this->PackGlyph(record.width, record.height, position);
+    } catch (Exceptions::FontError const &) {
+      return false;
+    }
+    if (position != Pair<Uint>(record.x, record.y) || layer != record.layer) {
+      return false;
+    }
+
+    if (pixels != 0) {
+      regions.push_back({record.x, record.y, layer, record.width,
+                         record.height, data + offset + sizeof(record)});
+    }
+
+    CharacterData c = CharacterData();
+    c.codepoint = record.codepoint;
+    c.layer = layer;
+    c.size = {record.width, record.height};
+    c.bearing = {record.bearingX, record.bearingY};
+    c.advance = record.advance;
+    c.uv[0] = record.x / tw;
+    c.uv[1] = record.y / th;
+    c.uv[2] = (record.x + record.width) / tw;
+    c.uv[3] = (record.y + record.height) / th;
+    mGlyphs.Insert(record.codepoint, c, mFrame);
+    offset += sizeof(record) + pixels;
+  }
+
+  // Pixels are uploaded straight from the mapping.
+  mTexture.LoadRegions(regions, 1);
+  mCacheSize = offset;
+  ++mGeneration;
+  return true;
+}
+
+Uint Font::EvictLayer() {
+  // Skyline packers can not free single rectangles, so whole layers are
+  // recycled. A layer is as old as the last use of its newest glyph.
+  Vec<Uint> ages(mPackers.size(), 0u);
+  for (Size i = 0; i < mGlyphs.GetSize(); ++i) {
+    Int layer = mGlyphs.GetGlyph(i).layer;
+    if (layer >= 0) {
+      ages[layer] = std::max(ages[layer], mGlyphs.GetLastUse(i));
+    }
+  }
+  Uint layer = std::min_element(ages.begin(), ages.end()) - ages.begin();
+  Uint oldest = mPins != 0 ? std::min(mPinnedFrame, mFrame) : mFrame;
+  if (ages[layer] >= oldest) {
+    throw Exceptions::FontError("Glyph atlas is full.");
+  }
+
+  // Erase moves the last record into the freed index, so scan backwards.
+  for (Size i = mGlyphs.GetSize(); i-- > 0;) {
+    if (mGlyphs.GetGlyph(i).layer == (Int)layer) {
+      mGlyphs.Erase(mGlyphs.GetCodepoint(i));
+    }
+  }
+  mPackers[layer].Clear();
+
+  // Stale texels in the padding would bleed into new neighbours.
+  Uint width = mTexture.GetWidth();
+  Uint height = mTexture.GetHeight();
+  Vec<Ubyte> blank((Size)width * height, 0u);
+  mTexture.LoadRegions({{0, 0, layer, width, height, blank.data()}}, 1);
+
+  // The cache replays packing from an empty atlas, which can not reproduce
+  // an evicted one.
+  mUnsaved.clear();
+  mCacheSealed = true;
+  ++mGeneration;
+  return layer;
+}
+
+Uint Font::PackGlyph(Uint const &width, Uint const &height,
+                     Pair<Uint> &position) {
+  Uint paddedWidth = width + sGlyphPadding;
+  Uint paddedHeight = height + sGlyphPadding;
+  if (paddedWidth > mTexture.GetWidth() ||
+      paddedHeight > mTexture.GetHeight()) {
+    throw Exceptions::FontError("Glyph is larger than glyph atlas.");
+  }
+
+  for (Uint layer = 0; layer < mPackers.size(); ++layer) {
+    if (mPackers[layer].Pack(paddedWidth, paddedHeight, position)) {
+      return layer;
+    }
+  }
+
+  Uint limit = Texture::GetMaxLayers();
+  if (mMaxLayers != 0) {
+    limit = std::min(limit, mMaxLayers);
+  }
+  if (mPackers.size() < limit) {
+    mPackers.push_back(
+        SkylinePacker(mTexture.GetWidth(), mTexture.GetHeight()));
+    mPackers.back().Pack(paddedWidth, paddedHeight, position);
+    return mPackers.size() - 1;
+  }
+
+  Uint layer = this->EvictLayer();
+  mPackers[layer].Pack(paddedWidth, paddedHeight, position);
+  return layer;
 }
 
 void Font::LoadDummyCharacter() {
@@ -14,69 +800,162 @@ void Font::LoadDummyCharacter() {
   chr.codepoint = 0;
   chr.size = {0, 0};
   chr.bearing = {0, 0};
-  chr.advance = 0;
-  chr.uv = {0, 0, 0, 0, 0};
+  // Glyphs still rasterizing in background take half an em, which keeps
+  // the line from jumping much when they land.
+  chr.advance = (mSize / 2) << 6;
 
-  mCharacters.insert({0, chr});
+  mGlyphs.Insert(0, chr);
 }
 
-Font::Font() {
-  mLibrary = Shared<FT_Library>(new FT_Library());
-  if (FT_Init_FreeType(mLibrary.get())) {
-    throw Exceptions::FontError("Failed to initialize FreeType.");
-    return;
+Bool Font::LoadSpaceCharacter(wchar_t const &character) {
+  if ((Uint)character != TC_UNICODE_HALF_SPACE &&
+      (Uint)character != TC_UNICODE_FULL_SPACE) {
+    return false;
   }
+
+  CharacterData c = CharacterData();
+  Uint width = ((Uint)character == TC_UNICODE_HALF_SPACE) ? mSize / 2 : mSize;
+  c.codepoint = (Uint)character;
+  c.size = {width, mSize};
+  c.bearing = {0, 0};
+  c.advance = width << 6;
+
+  mGlyphs.Insert(character, c, mFrame);
+  ++mGeneration;
+  return true;
 }
 
-Font::Font(Str const &path, Uint const &size) : mSize(size) {
-  mLibrary = Shared<FT_Library>(new FT_Library());
-  if (FT_Init_FreeType(mLibrary.get())) {
-    throw Exceptions::FontError("Failed to initialize FreeType.");
-    return;
+void Font::InsertGlyphs(Vec<GlyphBitmap> const &bitmaps) {
+  // Packing tall glyphs first keeps the skyline flat.
+  Vec<GlyphBitmap const *> order;
+  for (auto const &bitmap : bitmaps) {
+    order.push_back(&bitmap);
   }
-  this->LoadFont(path, size);
-}
+  std::stable_sort(order.begin(), order.end(),
+                   [](GlyphBitmap const *a, GlyphBitmap const *b) {
+                     return a->size.second > b->size.second;
+                   });
 
-Font::~Font() {
-  if (mFace.use_count() <= 1 && mLibrary.use_count() <= 1) {
-    if (mFace != nullptr) {
-      FT_Done_Face(*mFace);
-    }
-    if (mLibrary != nullptr) {
-      FT_Done_FreeType(*mLibrary);
+  Float tw = mTexture.GetWidth();
+  Float th = mTexture.GetHeight();
+  Vec<TextureRegion> regions;
+  try {
+    for (auto const *bitmap : order) {
+      // The cache replays packing, so skipped glyphs must not be packed.
+      if (mGlyphs.Find(bitmap->codepoint) != nullptr) {
+        continue;
+      }
+
+      auto const &[width, height] = bitmap->size;
+      Pair<Uint> position = {0, 0};
+      Uint layer = this->PackGlyph(width, height, position);
+      auto const &[x, y] = position;
+      if (width != 0 && height != 0) {
+        regions.push_back({x, y, layer, width, height, bitmap->pixels.data()});
+      }
+
+      CharacterData c = CharacterData();
+      c.codepoint = bitmap->codepoint;
+      c.layer = layer;
+      c.size = bitmap->size;
+      c.bearing = bitmap->bearing;
+      c.advance = bitmap->advance;
+      c.uv[0] = x / tw;
+      c.uv[1] = y / th;
+      c.uv[2] = (x + width) / tw;
+      c.uv[3] = (y + height) / th;
+      mGlyphs.Insert(bitmap->codepoint, c, mFrame);
+      if (mCachePath != "" && !mCacheSealed) {
+        mUnsaved.push_back(*bitmap);
+      }
     }
-    mCharacters.clear();
+  } catch (Exceptions::FontError const &) {
+    // Glyphs packed before the atlas filled up are still valid.
+    mTexture.LoadRegions(regions, 1);
+    ++mGeneration;
+    throw;
   }
+
+  mTexture.LoadRegions(regions, 1);
+  ++mGeneration;
+}
+
+Font::Font(Str const &path, Uint const &size, Uint const &glyphs,
+           FontRenderMode const &mode)
+    : mSize(size), mExpectedGlyphs(glyphs), mRenderMode(mode) {
+  this->LoadFont(path, size, glyphs, mode);
 }
 
 CharacterData const &Font::GetCharacter(wchar_t const &character) {
-  auto it = mCharacters.find(character);
-  if (it == mCharacters.end()) {
-    this->LoadCharacter(character);
-    it = mCharacters.find(character);
-  }
-  return it->second;
+  this->LoadCharacter(character);
+  return this->AcquireCharacter(character);
 }
 
 CharacterData const &Font::AcquireCharacter(wchar_t const &character) const {
-  auto it = mCharacters.find(character);
-  if (it == mCharacters.end()) {
-    return mCharacters.at(0);
+  CharacterData const *c = mGlyphs.Find(character);
+  if (c == nullptr) {
+    return *mGlyphs.Find(0);
   }
-  return it->second;
+  return *c;
+}
+
+Long Font::AcquireKerning(wchar_t const &left, wchar_t const &right) const {
+  if (!mHasKerning) {
+    return 0;
+  }
+
+  Ulong key = ((Ulong)(Uint)left << 32) | (Uint)right;
+  auto it = mKerning.find(key);
+  if (it != mKerning.end()) {
+    return it->second;
+  }
+
+  // Unfitted kerning keeps the fractional part, which the pen keeps too.
+  // Pairs drawn from different faces have no kerning.
+  FT_Vector kerning = {0, 0};
+  this->ActivateFaces();
+  FT_Face face = this->SelectFace(left);
+  if (face == this->SelectFace(right) && FT_HAS_KERNING(face)) {
+    FT_Get_Kerning(face, FT_Get_Char_Index(face, left),
+                   FT_Get_Char_Index(face, right), FT_KERNING_UNFITTED,
+                   &kerning);
+  }
+  mKerning.insert({key, kerning.x});
+  return kerning.x;
+}
+
+Long Font::Layout(WStr const &text, Vec<GlyphPosition> &positions) const {
+  positions.clear();
+  Long pen = 0;
+  wchar_t previous = 0;
+  for (wchar_t const &character : text) {
+    if (previous != 0) {
+      pen += this->AcquireKerning(previous, character);
+    }
+    CharacterData const &c = this->AcquireCharacter(character);
+    positions.push_back({&c, pen, 0});
+    pen += c.advance;
+    previous = character;
+  }
+  return pen;
 }
 
 Pair<Uint> Font::AcquireTextSize(WStr const &text) const {
-  Uint width = 0;
+  Long pen = 0;
   Uint height = 0;
+  wchar_t previous = 0;
   for (wchar_t const &character : text) {
+    if (previous != 0) {
+      pen += this->AcquireKerning(previous, character);
+    }
     CharacterData const &c = AcquireCharacter(character);
-    width += c.advance >> 6;
+    pen += c.advance;
     if (c.size.second > height) {
       height = c.size.second;
     }
+    previous = character;
   }
-  return {width, height};
+  return {(Uint)std::max<Long>(0, (pen + 32) >> 6), height};
 }
 
 Vec<CharacterData> Font::AcquireCharacters(WStr const &text) const {
@@ -88,78 +967,311 @@ Vec<CharacterData> Font::AcquireCharacters(WStr const &text) const {
   return characters;
 }
 
-void Font::LoadFont(Str const &path, Uint const &size) {
-  mFace = Shared<FT_Face>(new FT_Face());
-  if (FT_New_Face(*mLibrary, path.c_str(), 0, mFace.get())) {
-    throw Exceptions::FontError("Failed to load font.");
+void Font::SetSpread(Uint const &spread) {
+  if (spread < 2 || spread > 32) {
+    throw Exceptions::FontError("Distance field spread must be in [2, 32].");
     return;
   }
 
+  // The library is shared, so the spread is applied before rasterizing.
+  mSpread = spread;
+  if (mJobs != nullptr) {
+    mJobs->spread = spread;
+  }
+}
+
+void Font::LoadFont(Str const &path, Uint const &size, Uint const &glyphs,
+                    FontRenderMode const &mode) {
+  mFace = FontFace::Get(path);
+  mFallbacks.clear();
+  mFallbackPaths.clear();
+  mPath = path;
   mSize = size;
-  FT_Set_Pixel_Sizes(*mFace, 0, size);
-  this->InitializeTexture();
-  this->LoadDummyCharacter();
+  mExpectedGlyphs = glyphs;
+  mRenderMode = mode;
+  if (mode == FontRenderMode::SDF) {
+    this->SetSpread(mSpread);
+  }
+  mCachePath = "";
+  mCacheAppend = false;
+  mCacheSealed = false;
+  mUnsaved.clear();
+  this->ResetJobs();
+  FT_Face face = mFace->Activate(size);
+  FT_Size_Metrics const &metrics = face->size->metrics;
+  mAscender = metrics.ascender;
+  mDescender = metrics.descender;
+  mLineHeight = metrics.height;
+  mHasKerning = FT_HAS_KERNING(face);
+  mKerning.clear();
+  this->ResetAtlas();
+}
+
+void Font::AddFallback(Str const &path) {
+  if (mPath == "") {
+    throw Exceptions::FontError("Font is not loaded.");
+    return;
+  }
+
+  if (mCachePath != "") {
+    throw Exceptions::FontError("Add fallback faces before LoadCache.");
+    return;
+  }
+
+  Shared<FontFace> face = FontFace::Get(path);
+  mFallbacks.push_back(face);
+  mFallbackPaths.push_back(path);
+  mHasKerning = mHasKerning || FT_HAS_KERNING(face->GetFace());
+  mKerning.clear();
+  // Codepoints rendered as tofu so far may map in the new face.
+  this->ResetJobs();
+  this->ResetAtlas();
 }
 
 void Font::LoadCharacter(wchar_t const &character) {
-  if (mCharacters.find(character) != mCharacters.end()) {
+  if (mGlyphs.Touch(character, mFrame)) {
     return;
   }
 
-  if ((Uint)character == TC_UNICODE_HALF_SPACE ||
-      (Uint)character == TC_UNICODE_FULL_SPACE) {
-    CharacterData c = CharacterData();
-    Uint width = ((Uint)character == TC_UNICODE_HALF_SPACE) ? mSize / 2 : mSize;
-    c.codepoint = (Uint)character;
-    c.size = {width, mSize};
-    c.bearing = {0, 0};
-    c.advance = width << 6;
-    c.uv = {0, 0, 0, 0, 0};
-
-    mCharacters.insert({character, c});
+  if (this->LoadSpaceCharacter(character)) {
     return;
   }
 
-  if (FT_Load_Char(*mFace, character, FT_LOAD_RENDER)) {
-    throw Exceptions::FontError("Failed to load character.");
+  if (mExecutor != nullptr) {
+    if (mPending.insert((Uint)character).second) {
+      Shared<GlyphJobs> jobs = mJobs;
+      Uint codepoint = character;
+      mExecutor->Schedule([jobs, codepoint]() { jobs->Rasterize(codepoint); });
+    }
     return;
   }
 
-  Uint width = (*mFace)->glyph->bitmap.width;
-  Uint height = (*mFace)->glyph->bitmap.rows;
-  unsigned char *buffer = (*mFace)->glyph->bitmap.buffer;
+  this->ActivateFaces();
+  this->InsertGlyphs({RasterizeGlyph(this->SelectFace(character), character,
+                                     mRenderMode)});
+}
+
+void Font::LoadText(WStr const &text) {
+  for (wchar_t const &character : text) {
+    this->LoadCharacter(character);
+  }
+}
+
+void Font::LoadText(Str const &text) {
+  Size i = 0;
+  while (i < text.size()) {
+    Uint codepoint = (Ubyte)text[i];
+    Size length = 1;
+    if (codepoint >= 0x80) {
+      Unicode::DecodeCodepoint(text.data() + i, text.size() - i, codepoint,
+                               length);
+    }
+    if (sizeof(wchar_t) == 2 && codepoint > 0xFFFF) {
+      codepoint = Unicode::sReplacementCharacter;
+    }
+    this->LoadCharacter((wchar_t)codepoint);
+    i += length;
+  }
+}
 
-  Uint tw = mTexture.GetWidth();
-  Uint th = mTexture.GetHeight();
-  if (mXOffset + width >= tw) {
-    mXOffset = 0;
-    mYOffset += mSize;
+void Font::Prewarm(WStr const &charset, Executor *executor) {
+  Vec<Uint> codepoints;
+  Set<Uint> seen;
+  for (wchar_t const &character : charset) {
+    if (mGlyphs.Find(character) != nullptr ||
+        mPending.find((Uint)character) != mPending.end() ||
+        !seen.insert((Uint)character).second ||
+        this->LoadSpaceCharacter(character)) {
+      continue;
+    }
+    codepoints.push_back((Uint)character);
   }
-  if (mYOffset >= th) {
-    mYOffset = 0;
-    ++mZOffset;
+
+  Vec<GlyphBitmap> bitmaps(codepoints.size());
+  if (executor == nullptr || codepoints.size() <= 1) {
+    this->ActivateFaces();
+    for (Size i = 0; i < codepoints.size(); ++i) {
+      bitmaps[i] = RasterizeGlyph(this->SelectFace(codepoints[i]),
+                                  codepoints[i], mRenderMode);
+    }
+    this->InsertGlyphs(bitmaps);
+    return;
   }
 
-  mTexture.LoadDataAt(std::to_string((Uint)character), mXOffset, mYOffset,
-                      mZOffset, width, height, 1, buffer);
-  Vec<Float> uv = {(Float)mXOffset / tw, (Float)mYOffset / th,
-                   (Float)(mXOffset + width) / tw,
-                   (Float)(mYOffset + height) / th, (Float)mZOffset};
-  mXOffset += width;
+  // One task per worker, so each keeps a single face for its whole range.
+  Shared<GlyphJobs> jobs = mJobs;
+  Size workers = std::max(1u, std::thread::hardware_concurrency());
+  Size chunk = (codepoints.size() + workers - 1) / workers;
+  Vec<Handle> handles;
+  for (Size begin = 0; begin < codepoints.size(); begin += chunk) {
+    Size end = std::min(codepoints.size(), begin + chunk);
+    handles.push_back(executor->Schedule([&, jobs, begin, end]() {
+      GlyphRasterizer rasterizer = jobs->Acquire();
+      try {
+        for (Size i = begin; i < end; ++i) {
+          bitmaps[i] = RasterizeGlyph(
+              FindFace(rasterizer.faces, codepoints[i]), codepoints[i],
+              jobs->mode);
+        }
+      } catch (...) {
+        jobs->Release(rasterizer);
+        throw;
+      }
+      jobs->Release(rasterizer);
+    }));
+  }
 
-  CharacterData c = CharacterData();
-  c.codepoint = (Uint)character;
-  c.size = {width, height};
-  c.bearing = {(*mFace)->glyph->bitmap_left, (*mFace)->glyph->bitmap_top};
-  c.advance = (*mFace)->glyph->advance.x;
-  c.uv = uv;
+  // Every task must finish before the shared vectors go out of scope.
+  ExceptionPtr error = nullptr;
+  for (auto &handle : handles) {
+    try {
+      handle.get();
+    } catch (...) {
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
 
-  mCharacters.insert({character, c});
+  this->InsertGlyphs(bitmaps);
 }
 
-void Font::LoadText(WStr const &text) {
-  for (wchar_t const &character : text) {
-    this->LoadCharacter(character);
+void Font::Prewarm(Vec<WStr> const &strings, Executor *executor) {
+  WStr charset = L"";
+  for (auto const &string : strings) {
+    charset += string;
+  }
+  this->Prewarm(charset, executor);
+}
+
+Bool Font::LoadCache(Str const &path) {
+  if (mPath == "") {
+    throw Exceptions::FontError("Font is not loaded.");
+    return false;
+  }
+
+  mCachePath = path;
+  mCacheSealed = false;
+  mUnsaved.clear();
+  // Fallback files decide which face draws a codepoint, so they are part
+  // of the key.
+  mFontHash = mFace->GetHash();
+  for (auto const &face : mFallbacks) {
+    mFontHash = (mFontHash ^ face->GetHash()) * 1099511628211ull;
+  }
+  this->ResetAtlas();
+  mCacheAppend = this->ReplayCache();
+  if (!mCacheAppend) {
+    this->ResetAtlas();
+    mCacheSealed = false;
+  }
+  return mCacheAppend;
+}
+
+void Font::SaveCache() {
+  if (mCachePath == "") {
+    throw Exceptions::FontError("Cache file is not attached.");
+    return;
+  }
+
+  if (mCacheSealed || (mCacheAppend && mUnsaved.empty())) {
+    return;
+  }
+
+  if (mCacheAppend) {
+    if (!std::filesystem::exists(mCachePath)) {
+      throw Exceptions::FontError("Cache file was removed.");
+      return;
+    }
+    std::filesystem::resize_file(mCachePath, mCacheSize);
+  }
+
+  OutputFileStream stream(mCachePath,
+                          std::ios::binary | (mCacheAppend ? std::ios::app
+                                                           : std::ios::trunc));
+  if (!stream) {
+    throw Exceptions::FontError("Failed to open cache file.");
+    return;
+  }
+
+  if (!mCacheAppend) {
+    GlyphCacheHeader header = MakeCacheHeader(mFontHash, mSize, mRenderMode,
+                                              mSpread, mTexture.GetWidth());
+    stream.write((char const *)&header, sizeof(header));
+  }
+
+  Float tw = mTexture.GetWidth();
+  Float th = mTexture.GetHeight();
+  for (auto const &bitmap : mUnsaved) {
+    CharacterData const &c = *mGlyphs.Find(bitmap.codepoint);
+    GlyphCacheRecord record;
+    record.codepoint = bitmap.codepoint;
+    record.width = bitmap.size.first;
+    record.height = bitmap.size.second;
+    record.bearingX = bitmap.bearing.first;
+    record.bearingY = bitmap.bearing.second;
+    record.x = std::lround(c.uv[0] * tw);
+    record.y = std::lround(c.uv[1] * th);
+    record.layer = c.layer;
+    record.advance = bitmap.advance;
+    stream.write((char const *)&record, sizeof(record));
+    stream.write((char const *)bitmap.pixels.data(), bitmap.pixels.size());
+  }
+  stream.close();
+
+  mCacheSize = std::filesystem::file_size(mCachePath);
+  mCacheAppend = true;
+  mUnsaved.clear();
+}
+
+Bool Font::Update() {
+  ++mFrame;
+  if (mJobs == nullptr) {
+    return false;
+  }
+
+  Vec<GlyphBitmap> bitmaps;
+  Vec<Uint> failed;
+  {
+    LockGuard<Mutex> lock(mJobs->mutex);
+    bitmaps.swap(mJobs->ready);
+    failed.swap(mJobs->failed);
+  }
+
+  if (bitmaps.empty() && failed.empty()) {
+    return false;
+  }
+
+  // Glyphs the face can not render keep the placeholder for good.
+  for (Uint const &codepoint : failed) {
+    mPending.erase(codepoint);
+    CharacterData placeholder = *mGlyphs.Find(0);
+    mGlyphs.Insert(codepoint, placeholder, mFrame);
+  }
+  Vec<GlyphBitmap> missing;
+  for (auto &bitmap : bitmaps) {
+    mPending.erase(bitmap.codepoint);
+    if (mGlyphs.Find(bitmap.codepoint) == nullptr) {
+      missing.push_back(std::move(bitmap));
+    }
+  }
+  this->InsertGlyphs(missing);
+  return true;
+}
+
+void Font::Pin() {
+  if (mPins == 0) {
+    mPinnedFrame = mFrame;
+  }
+  ++mPins;
+}
+
+void Font::Unpin() {
+  if (mPins != 0) {
+    --mPins;
   }
 }
 } // namespace TerreateGraphics::Core
@@ -0,0 +1,840 @@
+#include "../includes/exceptions.hpp"
+#include "../includes/imageops.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+namespace ImageOps {
+typedef std::array<Ubyte, 256> LookupTable;
+
+static void ParallelFor(Executor *executor, Size const &count,
+                        Size const &minChunk,
+                        Function<void(Size, Size)> const &body) {
+  if (executor == nullptr || count <= minChunk) {
+    body(0, count);
+    return;
+  }
+
+  Size workers = std::max(1u, std::thread::hardware_concurrency());
+  Size chunk = std::max(minChunk, (count + workers * 4 - 1) / (workers * 4));
+  Vec<Handle> handles;
+  for (Size begin = 0; begin < count; begin += chunk) {
+    Size end = std::min(count, begin + chunk);
+    handles.push_back(
+        executor->Schedule([&body, begin, end]() { body(begin, end); }));
+  }
+  for (auto &handle : handles) {
+    handle.get();
+  }
+}
+
+static void ParallelRows(Executor *executor, Uint const &rows,
+                         Function<void(Size, Size)> const &body) {
+  ParallelFor(executor, rows, 16, body);
+}
+
+static Ubyte MulDiv255(Uint const &color, Uint const &alpha) {
+  Uint t = color * alpha + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+static Bool HasAlpha(Uint const &channels) {
+  return channels == 2 || channels == 4;
+}
+
+static void CheckChannels(TextureData const &data) {
+  if (data.channels < 1 || data.channels > 4) {
+    throw Exceptions::TextureError("Invalid number of channels.");
+  }
+  if (data.pixels.size() <
+      (Size)data.width * data.height * data.channels) {
+    throw Exceptions::TextureError("Pixel data is smaller than image size.");
+  }
+}
+
+static LookupTable BuildSRGBToLinearTable() {
+  LookupTable table;
+  for (Uint i = 0; i < 256; ++i) {
+    Double c = i / 255.0;
+    Double l = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+    table[i] = (Ubyte)std::lround(l * 255.0);
+  }
+  return table;
+}
+
+static LookupTable BuildLinearToSRGBTable() {
+  LookupTable table;
+  for (Uint i = 0; i < 256; ++i) {
+    Double l = i / 255.0;
+    Double c = l <= 0.0031308 ? l * 12.92
+                              : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+    table[i] = (Ubyte)std::lround(c * 255.0);
+  }
+  return table;
+}
+
+static void ApplyColorTable(TextureData &data, LookupTable const &table,
+                            Executor *executor) {
+  CheckChannels(data);
+  Uint channels = data.channels;
+  Uint colors = HasAlpha(channels) ? channels - 1 : channels;
+  Size stride = (Size)data.width * channels;
+  Ubyte *pixels = data.pixels.data();
+  ParallelRows(executor, data.height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte *row = pixels + y * stride;
+      for (Size x = 0; x < stride; x += channels) {
+        for (Uint c = 0; c < colors; ++c) {
+          row[x + c] = table[row[x + c]];
+        }
+      }
+    }
+  });
+}
+
+static void ExpandRowRGB(Ubyte const *src, Ubyte *dst, Uint const &width) {
+  Uint x = 0;
+#if defined(__SSSE3__)
+  __m128i const shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1,
+                                        9, 10, 11, -1);
+  __m128i const alpha = _mm_set1_epi32((Int)0xFF000000);
+  for (; (x + 4) * 3 + 4 <= width * 3; x += 4) {
+    __m128i px = _mm_loadu_si128((__m128i const *)(src + x * 3));
+    px = _mm_or_si128(_mm_shuffle_epi8(px, shuffle), alpha);
+    _mm_storeu_si128((__m128i *)(dst + x * 4), px);
+  }
+#elif defined(__ARM_NEON)
+  uint8x8_t const alpha = vdup_n_u8(255);
+  for (; x + 8 <= width; x += 8) {
+    uint8x8x3_t px = vld3_u8(src + x * 3);
+    uint8x8x4_t out = {{px.val[0], px.val[1], px.val[2], alpha}};
+    vst4_u8(dst + x * 4, out);
+  }
+#endif
+  for (; x < width; ++x) {
+    dst[x * 4] = src[x * 3];
+    dst[x * 4 + 1] = src[x * 3 + 1];
+    dst[x * 4 + 2] = src[x * 3 + 2];
+    dst[x * 4 + 3] = 255;
+  }
+}
+
+static void ExpandRowGray(Ubyte const *src, Ubyte *dst, Uint const &width) {
+  Uint x = 0;
+#if defined(__SSE2__)
+  __m128i const alpha = _mm_set1_epi8((char)0xFF);
+  for (; x + 16 <= width; x += 16) {
+    __m128i g = _mm_loadu_si128((__m128i const *)(src + x));
+    __m128i ggLo = _mm_unpacklo_epi8(g, g);
+    __m128i ggHi = _mm_unpackhi_epi8(g, g);
+    __m128i gaLo = _mm_unpacklo_epi8(g, alpha);
+    __m128i gaHi = _mm_unpackhi_epi8(g, alpha);
+    __m128i *out = (__m128i *)(dst + x * 4);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(ggLo, gaLo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(ggLo, gaLo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(ggHi, gaHi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(ggHi, gaHi));
+  }
+#elif defined(__ARM_NEON)
+  uint8x8_t const alpha = vdup_n_u8(255);
+  for (; x + 8 <= width; x += 8) {
+    uint8x8_t g = vld1_u8(src + x);
+    uint8x8x4_t out = {{g, g, g, alpha}};
+    vst4_u8(dst + x * 4, out);
+  }
+#endif
+  for (; x < width; ++x) {
+    dst[x * 4] = src[x];
+    dst[x * 4 + 1] = src[x];
+    dst[x * 4 + 2] = src[x];
+    dst[x * 4 + 3] = 255;
+  }
+}
+
+static void ExpandRowGrayAlpha(Ubyte const *src, Ubyte *dst,
+                               Uint const &width) {
+  for (Uint x = 0; x < width; ++x) {
+    dst[x * 4] = src[x * 2];
+    dst[x * 4 + 1] = src[x * 2];
+    dst[x * 4 + 2] = src[x * 2];
+    dst[x * 4 + 3] = src[x * 2 + 1];
+  }
+}
+
+#if defined(__SSE2__)
+static __m128i MulDiv255(__m128i const &color, __m128i const &alpha) {
+  __m128i t =
+      _mm_add_epi16(_mm_mullo_epi16(color, alpha), _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+#if defined(__AVX2__)
+static __m256i MulDiv255(__m256i const &color, __m256i const &alpha) {
+  __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(color, alpha),
+                               _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+#endif
+
+static void PremultiplyRowRGBA(Ubyte *row, Uint const &width) {
+  Uint x = 0;
+#if defined(__AVX2__)
+  __m256i const zero256 = _mm256_setzero_si256();
+  __m256i const mask256 = _mm256_set1_epi32((Int)0xFF000000);
+  for (; x + 8 <= width; x += 8) {
+    __m256i px = _mm256_loadu_si256((__m256i const *)(row + x * 4));
+    __m256i lo = _mm256_unpacklo_epi8(px, zero256);
+    __m256i hi = _mm256_unpackhi_epi8(px, zero256);
+    __m256i alo = _mm256_shufflehi_epi16(
+        _mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i ahi = _mm256_shufflehi_epi16(
+        _mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i res =
+        _mm256_packus_epi16(MulDiv255(lo, alo), MulDiv255(hi, ahi));
+    res = _mm256_or_si256(_mm256_andnot_si256(mask256, res),
+                          _mm256_and_si256(mask256, px));
+    _mm256_storeu_si256((__m256i *)(row + x * 4), res);
+  }
+#endif
+#if defined(__SSE2__)
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const mask = _mm_set1_epi32((Int)0xFF000000);
+  for (; x + 4 <= width; x += 4) {
+    __m128i px = _mm_loadu_si128((__m128i const *)(row + x * 4));
+    __m128i lo = _mm_unpacklo_epi8(px, zero);
+    __m128i hi = _mm_unpackhi_epi8(px, zero);
+    __m128i alo = _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i ahi = _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i res = _mm_packus_epi16(MulDiv255(lo, alo), MulDiv255(hi, ahi));
+    res = _mm_or_si128(_mm_andnot_si128(mask, res), _mm_and_si128(mask, px));
+    _mm_storeu_si128((__m128i *)(row + x * 4), res);
+  }
+#elif defined(__ARM_NEON)
+  for (; x + 8 <= width; x += 8) {
+    uint8x8x4_t px = vld4_u8(row + x * 4);
+    for (Uint c = 0; c < 3; ++c) {
+      uint16x8_t t = vmull_u8(px.val[c], px.val[3]);
+      px.val[c] = vraddhn_u16(t, vrshrq_n_u16(t, 8));
+    }
+    vst4_u8(row + x * 4, px);
+  }
+#endif
+  for (; x < width; ++x) {
+    Ubyte *px = row + x * 4;
+    px[0] = MulDiv255(px[0], px[3]);
+    px[1] = MulDiv255(px[1], px[3]);
+    px[2] = MulDiv255(px[2], px[3]);
+  }
+}
+
+static void BoxRowRGBA(Ubyte const *r0, Ubyte const *r1, Ubyte *dst,
+                       Uint const &srcWidth, Uint const &dstWidth) {
+  Uint x = 0;
+#if defined(__SSE2__)
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const round = _mm_set1_epi16(2);
+  for (; 2 * x + 4 <= srcWidth && x + 2 <= dstWidth; x += 2) {
+    __m128i a = _mm_loadu_si128((__m128i const *)(r0 + x * 8));
+    __m128i b = _mm_loadu_si128((__m128i const *)(r1 + x * 8));
+    __m128i s0 =
+        _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+    __m128i s1 =
+        _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+    s0 = _mm_add_epi16(s0, _mm_srli_si128(s0, 8));
+    s1 = _mm_add_epi16(s1, _mm_srli_si128(s1, 8));
+    __m128i sum = _mm_unpacklo_epi64(s0, s1);
+    sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+    _mm_storel_epi64((__m128i *)(dst + x * 4), _mm_packus_epi16(sum, zero));
+  }
+#elif defined(__ARM_NEON)
+  for (; 2 * x + 16 <= srcWidth && x + 8 <= dstWidth; x += 8) {
+    uint8x16x4_t a = vld4q_u8(r0 + x * 8);
+    uint8x16x4_t b = vld4q_u8(r1 + x * 8);
+    uint8x8x4_t out;
+    for (Uint c = 0; c < 4; ++c) {
+      uint16x8_t sum = vaddq_u16(vpaddlq_u8(a.val[c]), vpaddlq_u8(b.val[c]));
+      out.val[c] = vrshrn_n_u16(sum, 2);
+    }
+    vst4_u8(dst + x * 4, out);
+  }
+#endif
+  for (; x < dstWidth; ++x) {
+    Uint x0 = std::min(2 * x, srcWidth - 1);
+    Uint x1 = std::min(2 * x + 1, srcWidth - 1);
+    for (Uint c = 0; c < 4; ++c) {
+      Uint sum = r0[x0 * 4 + c] + r0[x1 * 4 + c] + r1[x0 * 4 + c] +
+                 r1[x1 * 4 + c];
+      dst[x * 4 + c] = (sum + 2) >> 2;
+    }
+  }
+}
+
+static void BoxRow(Ubyte const *r0, Ubyte const *r1, Ubyte *dst,
+                   Uint const &srcWidth, Uint const &dstWidth,
+                   Uint const &channels) {
+  for (Uint x = 0; x < dstWidth; ++x) {
+    Uint x0 = std::min(2 * x, srcWidth - 1);
+    Uint x1 = std::min(2 * x + 1, srcWidth - 1);
+    for (Uint c = 0; c < channels; ++c) {
+      Uint sum = r0[x0 * channels + c] + r0[x1 * channels + c] +
+                 r1[x0 * channels + c] + r1[x1 * channels + c];
+      dst[x * channels + c] = (sum + 2) >> 2;
+    }
+  }
+}
+
+static TextureData DownsampleBox(TextureData const &src, Executor *executor) {
+  TextureData dst;
+  dst.width = std::max(1u, src.width / 2);
+  dst.height = std::max(1u, src.height / 2);
+  dst.channels = src.channels;
+  dst.pixels.resize((Size)dst.width * dst.height * dst.channels);
+
+  Size srcStride = (Size)src.width * src.channels;
+  Size dstStride = (Size)dst.width * dst.channels;
+  ParallelRows(executor, dst.height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte const *r0 =
+          src.pixels.data() + std::min<Size>(2 * y, src.height - 1) * srcStride;
+      Ubyte const *r1 = src.pixels.data() +
+                        std::min<Size>(2 * y + 1, src.height - 1) * srcStride;
+      Ubyte *row = dst.pixels.data() + y * dstStride;
+      if (src.channels == 4) {
+        BoxRowRGBA(r0, r1, row, src.width, dst.width);
+      } else {
+        BoxRow(r0, r1, row, src.width, dst.width, src.channels);
+      }
+    }
+  });
+  return dst;
+}
+
+static Double BesselI0(Double const &x) {
+  Double sum = 1.0;
+  Double term = 1.0;
+  for (Uint k = 1; k < 32; ++k) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+static std::array<Float, 8> BuildKaiserKernel() {
+  Double const beta = 4.0;
+  Double const radius = 4.0;
+  std::array<Float, 8> kernel;
+  Double total = 0.0;
+  for (Uint k = 0; k < 8; ++k) {
+    Double d = k - 3.5;
+    Double x = d / 2.0;
+    Double sinc = std::sin(TC_PI * x) / (TC_PI * x);
+    Double t = d / radius;
+    Double window = BesselI0(beta * std::sqrt(1.0 - t * t)) / BesselI0(beta);
+    kernel[k] = sinc * window;
+    total += kernel[k];
+  }
+  for (auto &weight : kernel) {
+    weight /= total;
+  }
+  return kernel;
+}
+
+static TextureData DownsampleKaiser(TextureData const &src,
+                                    Executor *executor) {
+  static std::array<Float, 8> const kernel = BuildKaiserKernel();
+
+  TextureData dst;
+  dst.width = std::max(1u, src.width / 2);
+  dst.height = std::max(1u, src.height / 2);
+  dst.channels = src.channels;
+  dst.pixels.resize((Size)dst.width * dst.height * dst.channels);
+
+  Uint channels = src.channels;
+  Vec<Float> temp((Size)dst.width * src.height * channels);
+  ParallelRows(executor, src.height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte const *row = src.pixels.data() + y * src.width * channels;
+      Float *out = temp.data() + y * dst.width * channels;
+      for (Int x = 0; x < (Int)dst.width; ++x) {
+        for (Uint c = 0; c < channels; ++c) {
+          Float sum = 0.0f;
+          for (Int k = 0; k < 8; ++k) {
+            Int sx = std::clamp(2 * x - 3 + k, 0, (Int)src.width - 1);
+            sum += kernel[k] * row[sx * channels + c];
+          }
+          out[x * channels + c] = sum;
+        }
+      }
+    }
+  });
+
+  Size stride = (Size)dst.width * channels;
+  ParallelRows(executor, dst.height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte *out = dst.pixels.data() + y * stride;
+      for (Size i = 0; i < stride; ++i) {
+        Float sum = 0.0f;
+        for (Int k = 0; k < 8; ++k) {
+          Int sy = std::clamp((Int)(2 * y) - 3 + k, 0, (Int)src.height - 1);
+          sum += kernel[k] * temp[sy * stride + i];
+        }
+        out[i] = (Ubyte)std::clamp(std::lround(sum), 0l, 255l);
+      }
+    }
+  });
+  return dst;
+}
+
+static Double GetFilterRadius(ResampleFilter const &filter) {
+  switch (filter) {
+  case ResampleFilter::BOX:
+    return 0.5;
+  case ResampleFilter::MITCHELL:
+    return 2.0;
+  case ResampleFilter::LANCZOS3:
+    return 3.0;
+  default:
+    return 1.0;
+  }
+}
+
+static Double EvaluateFilter(ResampleFilter const &filter, Double const &x) {
+  Double ax = std::abs(x);
+  switch (filter) {
+  case ResampleFilter::BOX:
+    return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+  case ResampleFilter::MITCHELL: {
+    // Mitchell-Netravali with B = C = 1/3.
+    Double const b = 1.0 / 3.0;
+    Double const c = 1.0 / 3.0;
+    if (ax < 1.0) {
+      return ((12.0 - 9.0 * b - 6.0 * c) * ax * ax * ax +
+              (-18.0 + 12.0 * b + 6.0 * c) * ax * ax + (6.0 - 2.0 * b)) /
+             6.0;
+    }
+    if (ax < 2.0) {
+      return ((-b - 6.0 * c) * ax * ax * ax + (6.0 * b + 30.0 * c) * ax * ax +
+              (-12.0 * b - 48.0 * c) * ax + (8.0 * b + 24.0 * c)) /
+             6.0;
+    }
+    return 0.0;
+  }
+  case ResampleFilter::LANCZOS3: {
+    if (ax < 1e-8) {
+      return 1.0;
+    }
+    if (ax >= 3.0) {
+      return 0.0;
+    }
+    Double const pi = 3.14159265358979323846;
+    return 3.0 * std::sin(pi * ax) * std::sin(pi * ax / 3.0) /
+           (pi * pi * ax * ax);
+  }
+  default:
+    return std::max(0.0, 1.0 - ax);
+  }
+}
+
+static Float ResampleTap(Float const *weights, Ubyte const *row,
+                         Int const &first, Uint const &taps, Int const &last,
+                         Uint const &stride) {
+  Float sum = 0.0f;
+  for (Uint k = 0; k < taps; ++k) {
+    Int j = std::clamp(first + (Int)k, 0, last);
+    sum += weights[k] * (Float)row[j * stride];
+  }
+  return sum;
+}
+
+static Ushort FloatToHalfScalar(Float const &value) {
+  Uint bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  Uint sign = (bits >> 16) & 0x8000;
+  Uint rawExponent = (bits >> 23) & 0xFF;
+  Uint mantissa = bits & 0x7FFFFF;
+
+  if (rawExponent == 0xFF) {
+    return sign | 0x7C00 | (mantissa ? 0x200 | (mantissa >> 13) : 0);
+  }
+
+  Int exponent = (Int)rawExponent - 127 + 15;
+  if (exponent >= 31) {
+    return sign | 0x7C00;
+  }
+  if (exponent <= 0) {
+    if (exponent < -10) {
+      return sign;
+    }
+    mantissa |= 0x800000;
+    Uint shift = 14 - exponent;
+    Uint half = mantissa >> shift;
+    Uint rest = mantissa & ((1u << shift) - 1);
+    Uint middle = 1u << (shift - 1);
+    if (rest > middle || (rest == middle && (half & 1))) {
+      ++half;
+    }
+    return sign | half;
+  }
+
+  Uint half = ((Uint)exponent << 10) | (mantissa >> 13);
+  Uint rest = mantissa & 0x1FFF;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+    ++half;
+  }
+  return sign | half;
+}
+
+static Float HalfToFloatScalar(Ushort const &value) {
+  Uint sign = (Uint)(value & 0x8000) << 16;
+  Uint exponent = (value >> 10) & 0x1F;
+  Uint mantissa = value & 0x3FF;
+  Uint bits;
+
+  if (exponent == 0) {
+    if (mantissa == 0) {
+      bits = sign;
+    } else {
+      exponent = 113;
+      while (!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        --exponent;
+      }
+      bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+    }
+  } else if (exponent == 31) {
+    bits = sign | 0x7F800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  Float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+TextureData ExpandToRGBA(TextureData const &src, Executor *executor) {
+  CheckChannels(src);
+  if (src.channels == 4) {
+    return src;
+  }
+
+  TextureData dst;
+  dst.width = src.width;
+  dst.height = src.height;
+  dst.channels = 4;
+  dst.pixels.resize((Size)src.width * src.height * 4);
+
+  Size srcStride = (Size)src.width * src.channels;
+  Size dstStride = (Size)src.width * 4;
+  ParallelRows(executor, src.height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte const *in = src.pixels.data() + y * srcStride;
+      Ubyte *out = dst.pixels.data() + y * dstStride;
+      switch (src.channels) {
+      case 1:
+        ExpandRowGray(in, out, src.width);
+        break;
+      case 2:
+        ExpandRowGrayAlpha(in, out, src.width);
+        break;
+      default:
+        ExpandRowRGB(in, out, src.width);
+        break;
+      }
+    }
+  });
+  return dst;
+}
+
+void PremultiplyAlpha(TextureData &data, Executor *executor) {
+  CheckChannels(data);
+  if (!HasAlpha(data.channels)) {
+    return;
+  }
+
+  Size stride = (Size)data.width * data.channels;
+  Ubyte *pixels = data.pixels.data();
+  ParallelRows(executor, data.height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte *row = pixels + y * stride;
+      if (data.channels == 4) {
+        PremultiplyRowRGBA(row, data.width);
+        continue;
+      }
+      for (Size x = 0; x < stride; x += 2) {
+        row[x] = MulDiv255(row[x], row[x + 1]);
+      }
+    }
+  });
+}
+
+void FlipVertical(TextureData &data, Executor *executor) {
+  CheckChannels(data);
+  Size stride = (Size)data.width * data.channels;
+  Ubyte *pixels = data.pixels.data();
+  Uint height = data.height;
+  ParallelRows(executor, height / 2, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte *top = pixels + y * stride;
+      Ubyte *bottom = pixels + (height - 1 - y) * stride;
+      std::swap_ranges(top, top + stride, bottom);
+    }
+  });
+}
+
+void SRGBToLinear(TextureData &data, Executor *executor) {
+  static LookupTable const table = BuildSRGBToLinearTable();
+  ApplyColorTable(data, table, executor);
+}
+
+void LinearToSRGB(TextureData &data, Executor *executor) {
+  static LookupTable const table = BuildLinearToSRGBTable();
+  ApplyColorTable(data, table, executor);
+}
+
+TextureData Downsample(TextureData const &src, DownsampleFilter const &filter,
+                       Executor *executor) {
+  CheckChannels(src);
+  if (src.width == 0 || src.height == 0) {
+    throw Exceptions::TextureError("Cannot downsample empty image.");
+  }
+
+  switch (filter) {
+  case DownsampleFilter::KAISER:
+    return DownsampleKaiser(src, executor);
+  default:
+    return DownsampleBox(src, executor);
+  }
+}
+
+Vec<TextureData> GenerateMipChain(TextureData const &src,
+                                  DownsampleFilter const &filter,
+                                  Executor *executor) {
+  Vec<TextureData> levels = {src};
+  while (levels.back().width > 1 || levels.back().height > 1) {
+    levels.push_back(Downsample(levels.back(), filter, executor));
+  }
+  return levels;
+}
+
+ResampleWeights ComputeResampleWeights(Uint const &srcSize,
+                                       Uint const &dstSize,
+                                       ResampleFilter const &filter,
+                                       Double const &gain) {
+  if (srcSize == 0 || dstSize == 0) {
+    throw Exceptions::TextureError("Cannot resample empty image.");
+  }
+
+  Double scale = (Double)srcSize / dstSize;
+  Double factor =
+      filter == ResampleFilter::BILINEAR ? 1.0 : std::max(scale, 1.0);
+  Double support = GetFilterRadius(filter) * factor;
+
+  ResampleWeights result;
+  result.taps = (Uint)std::ceil(support * 2.0) + 1;
+  result.firsts.resize(dstSize);
+  result.weights.resize((Size)dstSize * result.taps);
+
+  Vec<Double> taps(result.taps);
+  for (Uint i = 0; i < dstSize; ++i) {
+    Double center = (i + 0.5) * scale;
+    Int first = (Int)std::floor(center - support);
+    Double total = 0.0;
+    for (Uint k = 0; k < result.taps; ++k) {
+      taps[k] = EvaluateFilter(filter, (first + k + 0.5 - center) / factor);
+      total += taps[k];
+    }
+
+    if (total == 0.0) {
+      // Degenerate support; fall back to the nearest texel.
+      std::fill(taps.begin(), taps.end(), 0.0);
+      taps[std::min((Uint)(center - first), result.taps - 1)] = 1.0;
+      total = 1.0;
+    }
+
+    result.firsts[i] = first;
+    for (Uint k = 0; k < result.taps; ++k) {
+      result.weights[(Size)i * result.taps + k] =
+          (Float)(taps[k] / total * gain);
+    }
+  }
+  return result;
+}
+
+TextureData Resample(TextureData const &src, Uint const &width,
+                     Uint const &height, ResampleFilter const &filter,
+                     Executor *executor) {
+  CheckChannels(src);
+  if (src.width == 0 || src.height == 0) {
+    throw Exceptions::TextureError("Cannot resample empty image.");
+  }
+
+  // Bytes are read as integers, with 1/255 folded into the horizontal
+  // weights, so no pass depends on how a division is rounded.
+  ResampleWeights horizontal =
+      ComputeResampleWeights(src.width, width, filter, 1.0 / 255.0);
+  ResampleWeights vertical = ComputeResampleWeights(src.height, height, filter);
+  Uint channels = src.channels;
+
+  // Both passes keep the exact summation order of the converter kernels and
+  // this file is built without floating point contraction. Additions and
+  // multiplications are correctly rounded on both sides, so results match
+  // the GPU bit for bit.
+  Vec<Float> buffer((Size)width * src.height * channels);
+  ParallelRows(executor, src.height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Ubyte const *row = src.pixels.data() + y * src.width * channels;
+      Float *out = buffer.data() + y * width * channels;
+      for (Uint x = 0; x < width; ++x) {
+        Float const *weights =
+            horizontal.weights.data() + (Size)x * horizontal.taps;
+        for (Uint c = 0; c < channels; ++c) {
+          out[x * channels + c] =
+              ResampleTap(weights, row + c, horizontal.firsts[x],
+                          horizontal.taps, src.width - 1, channels);
+        }
+      }
+    }
+  });
+
+  TextureData dst;
+  dst.width = width;
+  dst.height = height;
+  dst.channels = channels;
+  dst.pixels.resize((Size)width * height * channels);
+  Size pitch = (Size)width * channels;
+  ParallelRows(executor, height, [&](Size begin, Size end) {
+    for (Size y = begin; y < end; ++y) {
+      Float const *weights = vertical.weights.data() + y * vertical.taps;
+      Int first = vertical.firsts[y];
+      Ubyte *out = dst.pixels.data() + y * pitch;
+      for (Size i = 0; i < pitch; ++i) {
+        Float sum = 0.0f;
+        for (Uint k = 0; k < vertical.taps; ++k) {
+          Int j = std::clamp(first + (Int)k, 0, (Int)src.height - 1);
+          sum += weights[k] * buffer[j * pitch + i];
+        }
+        out[i] = (Ubyte)std::floor(std::clamp(sum, 0.0f, 1.0f) * 255.0f + 0.5f);
+      }
+    }
+  });
+  return dst;
+}
+
+void FloatToHalf(Float const *src, Ushort *dst, Size const &count,
+                 Executor *executor) {
+  ParallelFor(executor, count, 1u << 14, [src, dst](Size begin, Size end) {
+    Size i = begin;
+#if defined(__F16C__)
+    for (; i + 8 <= end; i += 8) {
+      __m256 v = _mm256_loadu_ps(src + i);
+      _mm_storeu_si128((__m128i *)(dst + i),
+                       _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= end; i += 4) {
+      float16x4_t h = vcvt_f16_f32(vld1q_f32(src + i));
+      vst1_u16(dst + i, vreinterpret_u16_f16(h));
+    }
+#endif
+    for (; i < end; ++i) {
+      dst[i] = FloatToHalfScalar(src[i]);
+    }
+  });
+}
+
+void HalfToFloat(Ushort const *src, Float *dst, Size const &count,
+                 Executor *executor) {
+  ParallelFor(executor, count, 1u << 14, [src, dst](Size begin, Size end) {
+    Size i = begin;
+#if defined(__F16C__)
+    for (; i + 8 <= end; i += 8) {
+      __m128i h = _mm_loadu_si128((__m128i const *)(src + i));
+      _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= end; i += 4) {
+      float16x4_t h = vreinterpret_f16_u16(vld1_u16(src + i));
+      vst1q_f32(dst + i, vcvt_f32_f16(h));
+    }
+#endif
+    for (; i < end; ++i) {
+      dst[i] = HalfToFloatScalar(src[i]);
+    }
+  });
+}
+} // namespace ImageOps
+
+ImagePipeline &ImagePipeline::ExpandToRGBA() {
+  return this->Then([](TextureData &data, Executor *executor) {
+    data = ImageOps::ExpandToRGBA(data, executor);
+  });
+}
+
+ImagePipeline &ImagePipeline::PremultiplyAlpha() {
+  return this->Then(ImageOps::PremultiplyAlpha);
+}
+
+ImagePipeline &ImagePipeline::FlipVertical() {
+  return this->Then(ImageOps::FlipVertical);
+}
+
+ImagePipeline &ImagePipeline::SRGBToLinear() {
+  return this->Then(ImageOps::SRGBToLinear);
+}
+
+ImagePipeline &ImagePipeline::LinearToSRGB() {
+  return this->Then(ImageOps::LinearToSRGB);
+}
+
+ImagePipeline &ImagePipeline::Downsample(DownsampleFilter const &filter) {
+  return this->Then([filter](TextureData &data, Executor *executor) {
+    data = ImageOps::Downsample(data, filter, executor);
+  });
+}
+
+ImagePipeline &ImagePipeline::Resample(Uint const &width, Uint const &height,
+                                      ResampleFilter const &filter) {
+  return this->Then([width, height, filter](TextureData &data,
+                                            Executor *executor) {
+    data = ImageOps::Resample(data, width, height, filter, executor);
+  });
+}
+
+ImagePipeline &
+ImagePipeline::Then(Function<void(TextureData &, Executor *)> const &op) {
+  mOperations.push_back(op);
+  return *this;
+}
+
+void ImagePipeline::Apply(TextureData &data, Executor *executor) const {
+  for (auto const &operation : mOperations) {
+    operation(data, executor);
+  }
+}
+
+TextureData ImagePipeline::Run(TextureData const &src,
+                               Executor *executor) const {
+  TextureData data = src;
+  this->Apply(data, executor);
+  return data;
+}
+} // namespace TerreateGraphics::Core
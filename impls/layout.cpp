@@ -0,0 +1,306 @@
+#include "../includes/exceptions.hpp"
+#include "../includes/layout.hpp"
+
+#include <algorithm>
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+// Closing punctuation and small kana never start a line.
+static WStr const sNoBreakBefore =
+    L"!),.:;?]}、。，．：；？！）」』】〕〉》〟ー々ゝゞヽヾ"
+    L"ぁぃぅぇぉっゃゅょゎァィゥェォッャュョヮヵヶ・";
+// Opening punctuation never ends a line.
+static WStr const sNoBreakAfter = L"([{「『【〔〈《〝（［｛";
+
+static Bool IsSpace(wchar_t const &c) {
+  return c == L' ' || c == L'\t' || c == 0x3000;
+}
+
+static Bool IsLineBreak(wchar_t const &c) { return c == L'\n' || c == 0x2028; }
+
+static Bool IsIdeographic(wchar_t const &c) {
+  return (c >= 0x2E80 && c <= 0x9FFF) || (c >= 0xAC00 && c <= 0xD7AF) ||
+         (c >= 0xF900 && c <= 0xFAFF) || (c >= 0xFF01 && c <= 0xFF60);
+}
+
+static Bool CanBreakBetween(wchar_t const &previous, wchar_t const &next) {
+  if (IsSpace(next) || sNoBreakBefore.find(next) != WStr::npos ||
+      sNoBreakAfter.find(previous) != WStr::npos) {
+    return false;
+  }
+
+  if (IsSpace(previous)) {
+    return true;
+  }
+
+  if ((previous == L'-' || previous == 0x2010) &&
+      !(next >= L'0' && next <= L'9')) {
+    return true;
+  }
+
+  return IsIdeographic(previous) || IsIdeographic(next);
+}
+
+static void HashBytes(Ulong &hash, void const *data, Size const &size) {
+  Ubyte const *bytes = static_cast<Ubyte const *>(data);
+  for (Size i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+  }
+}
+
+static Bool IsSameKey(Vec<TextRun> const &a, Vec<TextRun> const &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+
+  for (Size i = 0; i < a.size(); ++i) {
+    if (a[i].text != b[i].text || a[i].color != b[i].color ||
+        a[i].size != b[i].size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static Bool IsSameKey(TextLayoutSettings const &a,
+                      TextLayoutSettings const &b) {
+  return a.maxWidth == b.maxWidth && a.alignment == b.alignment &&
+         a.lineSpacing == b.lineSpacing;
+}
+
+void TextLayout::Build(Font *font, Vec<TextRun> const &runs,
+                       TextLayoutSettings const &settings) {
+  if (font == nullptr) {
+    throw Exceptions::FontError("Font is not loaded.");
+    return;
+  }
+
+  mFont = font;
+  mGlyphs.clear();
+  mLines.clear();
+  mSize = {0.0f, 0.0f};
+  mProvisional = false;
+
+  // Measure every character once. Kerning is kept apart because it is
+  // dropped at the start of a line.
+  Vec<wchar_t> characters;
+  Vec<Uint> owners;
+  Vec<Float> advances;
+  Vec<Float> kernings;
+  Vec<Float> scales;
+  for (Uint run = 0; run < runs.size(); ++run) {
+    font->LoadText(runs[run].text);
+  }
+  wchar_t previous = 0;
+  for (Uint run = 0; run < runs.size(); ++run) {
+    Float scale = 1.0f;
+    if (runs[run].size > 0.0f && font->GetFontSize() != 0) {
+      scale = runs[run].size / font->GetFontSize();
+    }
+    for (wchar_t const &character : runs[run].text) {
+      if (character == L'\r') {
+        continue;
+      }
+
+      Float advance = 0.0f;
+      Float kerning = 0.0f;
+      if (!IsLineBreak(character)) {
+        CharacterData const &c = font->AcquireCharacter(character);
+        if (c.codepoint == 0 && !IsSpace(character)) {
+          mProvisional = true;
+        }
+        advance = c.advance / 64.0f * scale;
+        if (previous != 0 && !IsLineBreak(previous)) {
+          kerning = font->AcquireKerning(previous, character) / 64.0f * scale;
+        }
+      }
+      characters.push_back(character);
+      owners.push_back(run);
+      advances.push_back(advance);
+      kernings.push_back(kerning);
+      scales.push_back(scale);
+      previous = character;
+    }
+  }
+  mGeneration = font->GetGeneration();
+
+  // Greedy breaking at the last opportunity that fits. A line that breaks
+  // is scanned again from its new start.
+  Size count = characters.size();
+  Vec<Pair<Size>> ranges;
+  Size begin = 0;
+  Size opportunity = 0;
+  Float pen = 0.0f;
+  for (Size i = 0; i < count; ++i) {
+    wchar_t const &character = characters[i];
+    if (IsLineBreak(character)) {
+      ranges.push_back({begin, i});
+      begin = i + 1;
+      opportunity = begin;
+      pen = 0.0f;
+      continue;
+    }
+
+    if (i > begin && CanBreakBetween(characters[i - 1], character)) {
+      opportunity = i;
+    }
+
+    Float width = (i > begin ? kernings[i] : 0.0f) + advances[i];
+    if (settings.maxWidth > 0.0f && i > begin && !IsSpace(character) &&
+        pen + width > settings.maxWidth) {
+      Size next = opportunity > begin ? opportunity : i;
+      ranges.push_back({begin, next});
+      begin = next;
+      opportunity = begin;
+      pen = 0.0f;
+      i = next - 1;
+      continue;
+    }
+    pen += width;
+  }
+  ranges.push_back({begin, count});
+
+  // Place glyphs on each line. Trailing spaces hang past the line width.
+  Float ascender = font->GetAscender() / 64.0f;
+  Float descender = -font->GetDescender() / 64.0f;
+  Float lineHeight = font->GetLineHeight() / 64.0f;
+  Float baseline = 0.0f;
+  Float descent = 0.0f;
+  for (Size line = 0; line < ranges.size(); ++line) {
+    auto const &[first, last] = ranges[line];
+    Float scale = 0.0f;
+    for (Size i = first; i < last; ++i) {
+      scale = std::max(scale, scales[i]);
+    }
+    if (first == last) {
+      // Empty lines take the size of the run holding their line break.
+      Size i = std::min(first, count - 1);
+      scale = count == 0 ? 1.0f : scales[i];
+    }
+
+    if (line == 0) {
+      baseline = -ascender * scale;
+    } else {
+      baseline -= lineHeight * scale * settings.lineSpacing;
+    }
+    descent = descender * scale;
+
+    LayoutLine result;
+    result.first = mGlyphs.size();
+    result.baseline = baseline;
+    Float x = 0.0f;
+    for (Size i = first; i < last; ++i) {
+      if (i > first) {
+        x += kernings[i];
+      }
+      if (!IsSpace(characters[i])) {
+        TextRun const &run = runs[owners[i]];
+        mGlyphs.push_back(
+            {(Uint)characters[i], x, baseline, scales[i], run.color});
+        result.width = x + advances[i];
+      }
+      x += advances[i];
+    }
+    result.count = mGlyphs.size() - result.first;
+    mLines.push_back(result);
+    mSize.first = std::max(mSize.first, result.width);
+  }
+  mSize.second = -baseline + descent;
+
+  // Lines are aligned within the widest one.
+  if (settings.alignment == TextAlignment::LEFT) {
+    return;
+  }
+  for (auto const &line : mLines) {
+    Float offset = mSize.first - line.width;
+    if (settings.alignment == TextAlignment::CENTER) {
+      offset *= 0.5f;
+    }
+    for (Uint i = line.first; i < line.first + line.count; ++i) {
+      mGlyphs[i].x += offset;
+    }
+  }
+}
+
+Ulong TextLayoutCache::Hash(Font const *font, Vec<TextRun> const &runs,
+                            TextLayoutSettings const &settings) {
+  Ulong hash = 0xCBF29CE484222325ull;
+  HashBytes(hash, &font, sizeof(font));
+  for (auto const &run : runs) {
+    Size length = run.text.size();
+    HashBytes(hash, &length, sizeof(length));
+    HashBytes(hash, run.text.data(), length * sizeof(wchar_t));
+    HashBytes(hash, &run.color, sizeof(run.color));
+    HashBytes(hash, &run.size, sizeof(run.size));
+  }
+  HashBytes(hash, &settings.maxWidth, sizeof(settings.maxWidth));
+  HashBytes(hash, &settings.alignment, sizeof(settings.alignment));
+  HashBytes(hash, &settings.lineSpacing, sizeof(settings.lineSpacing));
+  return hash;
+}
+
+void TextLayoutCache::Trim() {
+  if (mEntries.size() < std::max(mCapacity, 1u)) {
+    return;
+  }
+
+  // Keep the most recently used half.
+  Vec<Uint> uses;
+  for (auto const &[key, entry] : mEntries) {
+    uses.push_back(entry.lastUse);
+  }
+  Size keep = mCapacity / 2;
+  Uint threshold = mClock + 1;
+  if (keep != 0) {
+    std::nth_element(uses.begin(), uses.end() - keep, uses.end());
+    threshold = *(uses.end() - keep);
+  }
+  for (auto it = mEntries.begin(); it != mEntries.end();) {
+    if (it->second.lastUse < threshold) {
+      it = mEntries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+TextLayout const &
+TextLayoutCache::Acquire(Font *font, Vec<TextRun> const &runs,
+                         TextLayoutSettings const &settings) {
+  if (font == nullptr) {
+    throw Exceptions::FontError("Font is not loaded.");
+  }
+
+  ++mClock;
+  Ulong key = TextLayoutCache::Hash(font, runs, settings);
+  auto it = mEntries.find(key);
+  if (it != mEntries.end()) {
+    Entry &entry = it->second;
+    entry.lastUse = mClock;
+    if (entry.font == font && IsSameKey(entry.runs, runs) &&
+        IsSameKey(entry.settings, settings)) {
+      if (entry.layout.IsStale()) {
+        entry.layout.Build(font, runs, settings);
+      }
+      return entry.layout;
+    }
+
+    // Hash collision. The newer paragraph takes the slot.
+    entry.font = font;
+    entry.runs = runs;
+    entry.settings = settings;
+    entry.layout.Build(font, runs, settings);
+    return entry.layout;
+  }
+
+  this->Trim();
+  Entry &entry = mEntries[key];
+  entry.font = font;
+  entry.runs = runs;
+  entry.settings = settings;
+  entry.lastUse = mClock;
+  entry.layout.Build(font, runs, settings);
+  return entry.layout;
+}
+} // namespace TerreateGraphics::Core
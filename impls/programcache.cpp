@@ -0,0 +1,144 @@
+#include "../includes/device.hpp"
+#include "../includes/programcache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+namespace ProgramCache {
+// Cache file layout: one header followed by the driver's binary.
+struct ProgramBinaryHeader {
+  Ubyte magic[4] = {'T', 'G', 'P', 'B'};
+  Uint version = 1u;
+  Ulong key = 0u;
+  Uint format = 0u;
+  Uint length = 0u;
+};
+
+static Str sDirectory = "";
+
+static void HashBytes(Ulong &hash, void const *data, Size const &size) {
+  Ubyte const *bytes = static_cast<Ubyte const *>(data);
+  for (Size i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+  }
+}
+
+static void HashString(Ulong &hash, Str const &string) {
+  // Lengths keep ("ab", "c") apart from ("a", "bc").
+  Size length = string.size();
+  HashBytes(hash, &length, sizeof(length));
+  HashBytes(hash, string.data(), length);
+}
+
+static std::filesystem::path GetPath(Ulong const &key) {
+  Stream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+  return std::filesystem::path(sDirectory) / name.str();
+}
+
+Str const &GetDirectory() { return sDirectory; }
+
+void SetDirectory(Str const &path) { sDirectory = path; }
+
+Bool IsEnabled() { return sDirectory != "" && GetDeviceCaps().programBinary; }
+
+Ulong Hash(Vec<Str> const &sources) {
+  DeviceCaps const &caps = GetDeviceCaps();
+  Ulong hash = 0xCBF29CE484222325ull;
+  HashString(hash, caps.vendor);
+  HashString(hash, caps.renderer);
+  HashString(hash, caps.version);
+  Size count = sources.size();
+  HashBytes(hash, &count, sizeof(count));
+  for (auto const &source : sources) {
+    HashString(hash, source);
+  }
+  return hash;
+}
+
+Bool Load(Uint const &program, Ulong const &key) {
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  InputFileStream file(GetPath(key), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  ProgramBinaryHeader expected;
+  ProgramBinaryHeader header;
+  file.read((char *)&header, sizeof(header));
+  if (!file || std::memcmp(header.magic, expected.magic, 4) != 0 ||
+      header.version != expected.version || header.key != key ||
+      header.length == 0) {
+    return false;
+  }
+
+  Vec<Ubyte> binary(header.length);
+  file.read((char *)binary.data(), binary.size());
+  if (!file) {
+    return false;
+  }
+
+  // Drivers reject binaries of other builds by failing the link.
+  glProgramBinary(program, header.format, binary.data(), binary.size());
+  Int status = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  return status == GL_TRUE;
+}
+
+void Prepare(Uint const &program) {
+  glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void Save(Uint const &program, Ulong const &key) {
+  if (!IsEnabled()) {
+    return;
+  }
+
+  Int length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  ProgramBinaryHeader header;
+  header.key = key;
+  Vec<Ubyte> binary(length);
+  GLsizei written = 0;
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &written, &format, binary.data());
+  if (written <= 0) {
+    return;
+  }
+  header.format = format;
+  header.length = written;
+
+  // A cache that can not be written only costs the next launch a compile.
+  std::error_code error;
+  std::filesystem::create_directories(sDirectory, error);
+  std::filesystem::path path = GetPath(key);
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  {
+    OutputFileStream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return;
+    }
+    file.write((char const *)&header, sizeof(header));
+    file.write((char const *)binary.data(), header.length);
+    if (!file) {
+      file.close();
+      std::filesystem::remove(temporary, error);
+      return;
+    }
+  }
+  std::filesystem::rename(temporary, path, error);
+}
+} // namespace ProgramCache
+} // namespace TerreateGraphics::Core
@@ -0,0 +1,124 @@
+#include "../includes/exceptions.hpp"
+#include "../includes/residency.hpp"
+
+#include <algorithm>
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+Size ResidencyManager::GetUsage() const {
+  Size usage = 0;
+  for (auto const &[resource, entry] : mEntries) {
+    usage += entry.footprint();
+  }
+  return usage;
+}
+
+void ResidencyManager::SetBudget(Size const &budget) {
+  mBudget = budget;
+  this->Enforce();
+}
+
+void ResidencyManager::Register(Texture &texture,
+                                Function<void(Texture &)> const &restore) {
+  Entry entry;
+  entry.footprint = [&texture]() { return texture.GetByteSize(); };
+  entry.evict = [&texture]() {
+    if (texture.GetEvictedLevels() >= texture.GetLevels()) {
+      return false;
+    }
+    texture.Evict();
+    return true;
+  };
+  entry.restore = [&texture, restore]() {
+    if (texture.GetEvictedLevels() == 0) {
+      return;
+    }
+    texture.Restore();
+    if (restore) {
+      restore(texture);
+    }
+  };
+  entry.lastUse = ++mUseCount;
+  mEntries[&texture] = entry;
+  this->Enforce(&texture);
+}
+
+void ResidencyManager::Register(CubeTexture &texture,
+                                Function<void(CubeTexture &)> const &restore) {
+  Entry entry;
+  entry.footprint = [&texture]() { return texture.GetByteSize(); };
+  entry.evict = [&texture]() {
+    if (texture.GetEvictedLevels() >= texture.GetLevels()) {
+      return false;
+    }
+    texture.Evict();
+    return true;
+  };
+  entry.restore = [&texture, restore]() {
+    if (texture.GetEvictedLevels() == 0) {
+      return;
+    }
+    texture.Restore();
+    if (restore) {
+      restore(texture);
+    }
+  };
+  entry.lastUse = ++mUseCount;
+  mEntries[&texture] = entry;
+  this->Enforce(&texture);
+}
+
+void ResidencyManager::Register(Screen const &screen) {
+  Entry entry;
+  entry.footprint = [&screen]() { return screen.GetByteSize(); };
+  entry.lastUse = ++mUseCount;
+  mEntries[&screen] = entry;
+  this->Enforce(&screen);
+}
+
+void ResidencyManager::Touch(TerreateObjectBase const &resource) {
+  auto it = mEntries.find(&resource);
+  if (it == mEntries.end()) {
+    throw Exceptions::TextureError("Resource is not registered.");
+  }
+
+  it->second.lastUse = ++mUseCount;
+  if (it->second.restore) {
+    it->second.restore();
+  }
+  this->Enforce(&resource);
+}
+
+void ResidencyManager::Enforce(TerreateObjectBase const *keep) {
+  Size usage = this->GetUsage();
+  if (usage <= mBudget) {
+    return;
+  }
+
+  Vec<Entry *> candidates;
+  for (auto &[resource, entry] : mEntries) {
+    if (resource != keep && entry.evict) {
+      candidates.push_back(&entry);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](Entry const *a, Entry const *b) {
+              return a->lastUse < b->lastUse;
+            });
+
+  for (Entry *entry : candidates) {
+    while (usage > mBudget) {
+      Size before = entry->footprint();
+      if (!entry->evict()) {
+        break;
+      }
+      usage -= before - entry->footprint();
+    }
+
+    if (usage <= mBudget) {
+      return;
+    }
+  }
+}
+} // namespace TerreateGraphics::Core
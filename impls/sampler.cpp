@@ -0,0 +1,80 @@
+#include "../includes/device.hpp"
+#include "../includes/exceptions.hpp"
+#include "../includes/sampler.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+using namespace TerreateGraphics::GL;
+
+static std::unordered_map<SamplerDescriptor, Sampler, SamplerDescriptorHash>
+    sSamplerCache;
+
+Uint Sampler::sActiveUnit = 0u;
+
+Size SamplerDescriptorHash::operator()(
+    SamplerDescriptor const &descriptor) const {
+  Size hash = 0;
+  auto combine = [&hash](Size const &value) {
+    hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  };
+  combine((Size)descriptor.minFilter);
+  combine((Size)descriptor.magFilter);
+  combine((Size)descriptor.wrapS);
+  combine((Size)descriptor.wrapT);
+  combine((Size)descriptor.wrapR);
+  combine(std::hash<Float>()(descriptor.anisotropy));
+  combine(std::hash<Float>()(descriptor.lodBias));
+  combine((Size)descriptor.compare);
+  combine((Size)descriptor.compareFunction);
+  return hash;
+}
+
+Sampler::Sampler(SamplerDescriptor const &descriptor)
+    : mDescriptor(descriptor) {
+  glGenSamplers(1, mSampler);
+  glSamplerParameteri(mSampler, GL_TEXTURE_MIN_FILTER,
+                      (GLenum)descriptor.minFilter);
+  glSamplerParameteri(mSampler, GL_TEXTURE_MAG_FILTER,
+                      (GLenum)descriptor.magFilter);
+  glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_S, (GLenum)descriptor.wrapS);
+  glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_T, (GLenum)descriptor.wrapT);
+  glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_R, (GLenum)descriptor.wrapR);
+  glSamplerParameterf(mSampler, GL_TEXTURE_LOD_BIAS, descriptor.lodBias);
+
+  DeviceCaps const &caps = GetDeviceCaps();
+  if (descriptor.anisotropy > 1.0f && caps.anisotropy) {
+    glSamplerParameterf(mSampler, GL_TEXTURE_MAX_ANISOTROPY,
+                        std::min(descriptor.anisotropy, caps.maxAnisotropy));
+  }
+
+  if (descriptor.compare) {
+    glSamplerParameteri(mSampler, GL_TEXTURE_COMPARE_MODE,
+                        GL_COMPARE_REF_TO_TEXTURE);
+    glSamplerParameteri(mSampler, GL_TEXTURE_COMPARE_FUNC,
+                        (GLenum)descriptor.compareFunction);
+  }
+}
+
+Sampler::~Sampler() {
+  if (mSampler.Count() <= 1) {
+    if ((TCu32)mSampler != 0u) {
+      glDeleteSamplers(1, mSampler);
+    }
+    mSampler.Delete();
+  }
+}
+
+Sampler const &Sampler::Get(SamplerDescriptor const &descriptor) {
+  auto it = sSamplerCache.find(descriptor);
+  if (it != sSamplerCache.end()) {
+    return it->second;
+  }
+  return sSamplerCache.emplace(descriptor, Sampler(descriptor)).first->second;
+}
+
+void Sampler::ClearCache() { sSamplerCache.clear(); }
+} // namespace TerreateGraphics::Core
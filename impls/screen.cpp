@@ -18,7 +18,8 @@ Screen::Screen(Uint const &width, Uint const &height, Uint const &layers)
   GLObject buffer = GLObject();
   glGenTextures(1, buffer);
   glBindTexture(GL_TEXTURE_2D_ARRAY, buffer);
-  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32F, mWidth, mHeight, layers);
+  Texture::AllocateStorage(GL_TEXTURE_2D_ARRAY, 1, TextureChannelType::RGBA32F,
+                           mWidth, mHeight, layers);
   glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
   for (Uint i = 0; i < layers; i++) {
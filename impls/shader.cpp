@@ -1,6 +1,9 @@
 #include "../includes/exceptions.hpp"
+#include "../includes/programcache.hpp"
 #include "../includes/shader.hpp"
 
+#include <algorithm>
+
 namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
 
@@ -46,6 +49,78 @@ void CheckLinkStatus(Uint const &id) {
   }
 }
 
+// Components of a uniform type and the type they are read back as. Double
+// types are not shadowed.
+static Uint GetUniformComponents(GLenum const &type, GLenum &base) {
+  base = GL_FLOAT;
+  switch (type) {
+  case GL_FLOAT:
+    return 1;
+  case GL_FLOAT_VEC2:
+    return 2;
+  case GL_FLOAT_VEC3:
+    return 3;
+  case GL_FLOAT_VEC4:
+  case GL_FLOAT_MAT2:
+    return 4;
+  case GL_FLOAT_MAT2x3:
+  case GL_FLOAT_MAT3x2:
+    return 6;
+  case GL_FLOAT_MAT2x4:
+  case GL_FLOAT_MAT4x2:
+    return 8;
+  case GL_FLOAT_MAT3:
+    return 9;
+  case GL_FLOAT_MAT3x4:
+  case GL_FLOAT_MAT4x3:
+    return 12;
+  case GL_FLOAT_MAT4:
+    return 16;
+  case GL_DOUBLE:
+  case GL_DOUBLE_VEC2:
+  case GL_DOUBLE_VEC3:
+  case GL_DOUBLE_VEC4:
+  case GL_DOUBLE_MAT2:
+  case GL_DOUBLE_MAT2x3:
+  case GL_DOUBLE_MAT2x4:
+  case GL_DOUBLE_MAT3:
+  case GL_DOUBLE_MAT3x2:
+  case GL_DOUBLE_MAT3x4:
+  case GL_DOUBLE_MAT4:
+  case GL_DOUBLE_MAT4x2:
+  case GL_DOUBLE_MAT4x3:
+    return 0;
+  case GL_UNSIGNED_INT:
+    base = GL_UNSIGNED_INT;
+    return 1;
+  case GL_UNSIGNED_INT_VEC2:
+    base = GL_UNSIGNED_INT;
+    return 2;
+  case GL_UNSIGNED_INT_VEC3:
+    base = GL_UNSIGNED_INT;
+    return 3;
+  case GL_UNSIGNED_INT_VEC4:
+    base = GL_UNSIGNED_INT;
+    return 4;
+  case GL_INT_VEC2:
+  case GL_BOOL_VEC2:
+    base = GL_INT;
+    return 2;
+  case GL_INT_VEC3:
+  case GL_BOOL_VEC3:
+    base = GL_INT;
+    return 3;
+  case GL_INT_VEC4:
+  case GL_BOOL_VEC4:
+    base = GL_INT;
+    return 4;
+  default:
+    // Ints, bools, samplers and images hold one int.
+    base = GL_INT;
+    return 1;
+  }
+}
+
 Shader::Shader() {
   mShaderID = glCreateProgram();
   mCompiled = false;
@@ -86,6 +161,9 @@ void Shader::SetStencilOperation(StencilOperation const &sFail,
 }
 
 void Shader::Compile() {
+  // State of an earlier compile must not decide how this one links.
+  mBinaryLoaded = false;
+  mCacheKey = 0u;
   if (mVertexShaderSource == "") {
     throw Exceptions::ShaderError("Vertex shader source is empty");
     return;
@@ -96,6 +174,16 @@ void Shader::Compile() {
     return;
   }
 
+  if (ProgramCache::IsEnabled()) {
+    mCacheKey = ProgramCache::Hash(
+        {mVertexShaderSource, mFragmentShaderSource, mGeometryShaderSource});
+    if (ProgramCache::Load(mShaderID, mCacheKey)) {
+      mBinaryLoaded = true;
+      mCompiled = true;
+      return;
+    }
+  }
+
   ID vertID = 0;
   vertID = glCreateShader(GL_VERTEX_SHADER);
   char const *vertSource = mVertexShaderSource.c_str();
@@ -132,9 +220,78 @@ void Shader::Link() {
     return;
   }
 
-  glLinkProgram(mShaderID);
-  CheckLinkStatus(mShaderID);
+  // Programs loaded from the cache are already linked.
+  if (!mBinaryLoaded) {
+    if (mCacheKey != 0) {
+      ProgramCache::Prepare(mShaderID);
+    }
+    glLinkProgram(mShaderID);
+    CheckLinkStatus(mShaderID);
+    if (mCacheKey != 0) {
+      ProgramCache::Save(mShaderID, mCacheKey);
+    }
+  }
   mLinked = true;
+  this->ReflectUniforms();
+}
+
+void Shader::ReflectUniforms() {
+  UniformTable table;
+  Int count = 0;
+  Int maxLength = 0;
+  glGetProgramiv(mShaderID, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(mShaderID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  Vec<char> buffer(std::max(maxLength, 1));
+  for (Int i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(mShaderID, i, buffer.size(), &length, &size, &type,
+                       buffer.data());
+    Str name(buffer.data(), length);
+    Int location = glGetUniformLocation(mShaderID, name.c_str());
+    if (location < 0) {
+      continue; // Members of uniform blocks have no location.
+    }
+
+    // Arrays are reported as name[0]. Every element gets a handle, and the
+    // bare name aliases the first.
+    Bool array =
+        name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+    Str stem = array ? name.substr(0, name.size() - 3) : name;
+    GLenum base = GL_FLOAT;
+    Uint element = GetUniformComponents(type, base) * sizeof(Float);
+    Uint begin = table.shadow.size();
+    table.shadow.resize(begin + (Size)element * size);
+    for (Int e = 0; e < size; ++e) {
+      Str key = array ? stem + "[" + std::to_string(e) + "]" : stem;
+      UniformHandle handle;
+      handle.location =
+          e == 0 ? location : glGetUniformLocation(mShaderID, key.c_str());
+      handle.offset = begin + e * element;
+      handle.capacity = element * (size - e);
+
+      // The shadow starts from the values the program was linked with.
+      void *value = table.shadow.data() + handle.offset;
+      if (element == 0 || handle.location < 0) {
+        handle.capacity = 0;
+      } else if (base == GL_FLOAT) {
+        glGetUniformfv(mShaderID, handle.location, (Float *)value);
+      } else if (base == GL_INT) {
+        glGetUniformiv(mShaderID, handle.location, (Int *)value);
+      } else {
+        glGetUniformuiv(mShaderID, handle.location, (Uint *)value);
+      }
+
+      table.handles.insert({key, handle});
+      if (array && e == 0) {
+        table.handles.insert({stem, handle});
+      }
+    }
+  }
+
+  // Copies share the table, so they see the new program too.
+  *mUniforms = std::move(table);
 }
 
 Str Shader::LoadShaderSource(const Str &path) {
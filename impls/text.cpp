@@ -1,60 +1,111 @@
 #include "../includes/exceptions.hpp"
 #include "../includes/text.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
 using namespace TerreateCore::Math;
 
+// Floats per glyph quad: 4 vertices of position and uv.
+static Uint const sQuadFloats = 24u;
+// Vertices of the triangle strip each glyph instance expands to.
+static Uint const sInstanceVertices = 4u;
+
 void Text::LoadText() {
-  if (mText == mLastText) {
+  // Loading touches every glyph, so text drawn unchanged each frame keeps
+  // its atlas layers from being evicted. Glyphs rasterized in background
+  // replace placeholders once they land.
+  mFont->LoadText(mText);
+  Bool atlasChanged = mFont->GetGeneration() != mLastGeneration;
+  if (mText == mLastText && !atlasChanged) {
     return;
   }
 
-  mFont->LoadText(mText);
-  auto chars = mFont->AcquireCharacters(mText);
+  mFont->Layout(mText, mPositions);
 
-  Vec<Vec<Float>> vertices;
-  Vec<Uint> indices;
-  Float px = 0.0f;
-  Uint count = 0;
-  for (auto &chr : chars) {
-    if (chr.codepoint == 0) { // Skip dummy characters
-      px += chr.advance >> 6;
-      continue;
+  // Quads before the first changed character keep their pen positions, so
+  // only the tail is rebuilt and uploaded.
+  Uint first = 0;
+  if (!atlasChanged && mQuadCapacity != 0) {
+    Uint common = std::min(mText.size(), mLastText.size());
+    while (first < common && mText[first] == mLastText[first]) {
+      ++first;
     }
+    first = std::min<Uint>(first, mQuadOffsets.size() - 1);
+  }
+  Uint firstQuad = mQuadOffsets.empty() ? 0 : mQuadOffsets[first];
 
+  // Bitmap glyphs are snapped to whole pixels to stay sharp. Distance
+  // fields are resampled anyway, so they keep the subpixel pen.
+  Bool snap = mFont->GetRenderMode() == FontRenderMode::BITMAP;
+  mVertices.resize((Size)firstQuad * sQuadFloats);
+  mQuadOffsets.resize(first + 1);
+  mQuadOffsets[first] = firstQuad;
+  Uint count = firstQuad;
+  for (Uint i = first; i < mPositions.size(); ++i) {
+    GlyphPosition const &position = mPositions[i];
+    CharacterData const &chr = *position.character;
     Uint c = chr.codepoint;
-    if (c == TC_UNICODE_HALF_SPACE ||
-        c == TC_UNICODE_FULL_SPACE) { // Skip spaces
-      px += chr.advance >> 6;
-      continue;
+    // Skip dummy characters and spaces
+    if (c != 0 && c != TC_UNICODE_HALF_SPACE && c != TC_UNICODE_FULL_SPACE) {
+      Float px = snap ? (Float)((position.x + 32) >> 6) : position.x / 64.0f;
+      Float layer = chr.layer;
+      Float w = chr.size.first;
+      Float h = chr.size.second;
+      Float x = px + chr.bearing.first;
+      Float y = position.y / 64.0f + chr.bearing.second - h;
+      Float u0 = chr.uv[0];
+      Float v0 = chr.uv[1];
+      Float u1 = chr.uv[2];
+      Float v1 = chr.uv[3];
+      mVertices.insert(mVertices.end(),
+                       {x,     y + h, 0.0f, u0, v0, layer,
+                        x,     y,     0.0f, u0, v1, layer,
+                        x + w, y,     0.0f, u1, v1, layer,
+                        x + w, y + h, 0.0f, u1, v0, layer});
+      ++count;
+    }
+    mQuadOffsets.push_back(count);
+  }
+
+  if (count > mQuadCapacity || mQuadCapacity == 0) {
+    // Grow geometrically. The same buffers are respecified, so no OpenGL
+    // object is created after the first load.
+    Uint capacity = std::max({count, mQuadCapacity * 2, 16u});
+    Ulong size = (Ulong)capacity * sQuadFloats * sizeof(Float);
+    if (mQuadCapacity == 0) {
+      mBuffer.AllocateData(size, mAttributes, mLocations);
+    } else {
+      mBuffer.ReallocateData(0, size);
     }
 
-    Float w = chr.size.first;
-    Float h = chr.size.second;
-    Float x = px + chr.bearing.first;
-    Float y = chr.bearing.second - h;
-    vertices.push_back({x, y + h, 0.0f});
-    vertices.push_back({chr.uv[0], chr.uv[1], chr.uv[4]});
-    vertices.push_back({x, y, 0.0f});
-    vertices.push_back({chr.uv[0], chr.uv[3], chr.uv[4]});
-    vertices.push_back({x + w, y, 0.0f});
-    vertices.push_back({chr.uv[2], chr.uv[3], chr.uv[4]});
-    vertices.push_back({x + w, y + h, 0.0f});
-    vertices.push_back({chr.uv[2], chr.uv[1], chr.uv[4]});
-    indices.push_back(count);
-    indices.push_back(count + 1);
-    indices.push_back(count + 2);
-    indices.push_back(count + 2);
-    indices.push_back(count + 3);
-    indices.push_back(count);
-    count += 4;
-    px += chr.advance >> 6;
-  }
-
-  mBuffer.LoadData(mBuffer.Flatten(vertices), mAttributes, mLocations);
-  mBuffer.LoadIndices(indices);
+    // Quads share one index pattern, which only changes with capacity.
+    mIndices.clear();
+    for (Uint quad = 0; quad < capacity; ++quad) {
+      Uint base = quad * 4;
+      mIndices.insert(mIndices.end(),
+                      {base, base + 1, base + 2, base + 2, base + 3, base});
+    }
+    mBuffer.LoadIndices(mIndices);
+    mQuadCapacity = capacity;
+    firstQuad = 0;
+  }
+
+  Ulong firstFloat = (Ulong)firstQuad * sQuadFloats;
+  mBuffer.ReloadData(mVertices, firstFloat, mVertices.size() - firstFloat);
+  mBuffer.SetIndexCount((Ulong)count * 6);
   mLastText = mText;
+  mLastGeneration = mFont->GetGeneration();
+}
+
+void Text::AcquireUniforms() {
+  mTextureUniform = mShader.GetUniform("uTexture");
+  mModelUniform = mShader.GetUniform("uModel");
+  mTransformUniform = mShader.GetUniform("uTransform");
+  mColorUniform = mShader.GetUniform("uColor");
+  mShaderLoaded = true;
 }
 
 void Text::LoadShader(Str const &vertexPath, Str const &fragmentPath) {
@@ -62,7 +113,7 @@ void Text::LoadShader(Str const &vertexPath, Str const &fragmentPath) {
   mShader.AddFragmentShaderSource(Shader::LoadShaderSource(fragmentPath));
   mShader.Compile();
   mShader.Link();
-  mShaderLoaded = true;
+  this->AcquireUniforms();
 }
 
 void Text::LoadText(WStr const &text) {
@@ -76,13 +127,22 @@ void Text::Render(Float const &x, Float const &y, Float const &windowWidth,
     throw Exceptions::TextError("Shader not loaded");
   }
 
+  mFont->Update();
+  this->LoadText();
+
   mShader.Use();
   Shader::ActivateTexture(TextureTargets::TEX_0);
-  mShader.SetInt("uTexture", 0);
+  mShader.SetInt(mTextureUniform, 0);
 
-  mShader.SetMat4("uModel", translate(identity<mat4>(), vec3(x, y, 0.0f)));
-  mShader.SetMat4("uTransform", ortho(0.0f, windowWidth, 0.0f, windowHeight));
-  mShader.SetVec3("uColor", mColor);
+  Float s = 1.0f;
+  if (mSize > 0.0f && mFont->GetFontSize() != 0) {
+    s = mSize / mFont->GetFontSize();
+  }
+  mat4 model = translate(identity<mat4>(), vec3(x, y, 0.0f));
+  mShader.SetMat4(mModelUniform, scale(model, vec3(s, s, 1.0f)));
+  mShader.SetMat4(mTransformUniform,
+                  ortho(0.0f, windowWidth, 0.0f, windowHeight));
+  mShader.SetVec3(mColorUniform, mColor);
 
   mFont->Use();
   mBuffer.Draw(DrawMode::TRIANGLES);
@@ -92,7 +152,7 @@ void Text::Render(Float const &x, Float const &y, Float const &windowWidth,
 }
 
 Text &Text::operator=(Str const &text) {
-  this->LoadText(WStr(text.begin(), text.end()));
+  this->LoadText(text);
   return *this;
 }
 
@@ -100,4 +160,215 @@ Text &Text::operator=(WStr const &text) {
   this->LoadText(text);
   return *this;
 }
+
+static Ushort NormalizeUV(Float const &value) {
+  return (Ushort)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+}
+
+static Ubyte NormalizeColor(Float const &value) {
+  return (Ubyte)std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+}
+
+// Appends one colored glyph instance. x and y are the pen position and
+// baseline in pixels, s the scale from font size.
+static void AppendGlyph(Vec<GlyphInstance> &instances,
+                        CharacterData const &chr, Float const &x,
+                        Float const &y, Float const &s, vec3 const &color) {
+  GlyphInstance &instance = instances.emplace_back();
+  Float h = chr.size.second * s;
+  instance.rect[0] = x + chr.bearing.first * s;
+  instance.rect[1] = y + chr.bearing.second * s - h;
+  instance.rect[2] = chr.size.first * s;
+  instance.rect[3] = h;
+  // The atlas stores rows top down, so the bottom edge samples v1.
+  instance.uv[0] = NormalizeUV(chr.uv[0]);
+  instance.uv[1] = NormalizeUV(chr.uv[3]);
+  instance.uv[2] = NormalizeUV(chr.uv[2]);
+  instance.uv[3] = NormalizeUV(chr.uv[1]);
+  instance.layer = (Ushort)chr.layer;
+  instance.color[0] = NormalizeColor(color.x);
+  instance.color[1] = NormalizeColor(color.y);
+  instance.color[2] = NormalizeColor(color.z);
+}
+
+TextBatch::FontBatch &TextBatch::AcquireBatch(Font *font) {
+  // A frame uses a handful of fonts, so a linear scan beats hashing.
+  for (auto &batch : mBatches) {
+    if (batch.font == font) {
+      if (!batch.submitted) {
+        batch.submitted = true;
+        font->Pin();
+      }
+      return batch;
+    }
+  }
+  font->Pin();
+  mBatches.push_back({font, true, {}});
+  return mBatches.back();
+}
+
+Uint TextBatch::GetQuadCount() const {
+  Uint count = 0;
+  for (auto const &batch : mBatches) {
+    count += batch.instances.size();
+  }
+  return count;
+}
+
+void TextBatch::AcquireUniforms() {
+  mTextureUniform = mShader.GetUniform("uTexture");
+  mTransformUniform = mShader.GetUniform("uTransform");
+  mShaderLoaded = true;
+}
+
+void TextBatch::LoadShader(Str const &vertexPath, Str const &fragmentPath) {
+  mShader.AddVertexShaderSource(Shader::LoadShaderSource(vertexPath));
+  mShader.AddFragmentShaderSource(Shader::LoadShaderSource(fragmentPath));
+  mShader.Compile();
+  mShader.Link();
+  this->AcquireUniforms();
+}
+
+void TextBatch::Submit(WStr const &text, Font *font, Float const &x,
+                       Float const &y, vec3 const &color, Float const &size) {
+  if (font == nullptr) {
+    throw Exceptions::TextError("Font not loaded");
+    return;
+  }
+
+  // The batch pins the font until Flush, so glyphs used by earlier
+  // submissions of this frame are never evicted before they are drawn, even
+  // when Text::Render updates the same font in between.
+  Vec<GlyphInstance> &instances = this->AcquireBatch(font).instances;
+  font->LoadText(text);
+  font->Layout(text, mPositions);
+
+  Float s = 1.0f;
+  if (size > 0.0f && font->GetFontSize() != 0) {
+    s = size / font->GetFontSize();
+  }
+
+  // Same placement as Text, with the model transform applied here so every
+  // string shares one projection uniform.
+  Bool snap = font->GetRenderMode() == FontRenderMode::BITMAP;
+  for (auto const &position : mPositions) {
+    CharacterData const &chr = *position.character;
+    Uint c = chr.codepoint;
+    if (c == 0 || c == TC_UNICODE_HALF_SPACE || c == TC_UNICODE_FULL_SPACE) {
+      continue;
+    }
+
+    Float px = snap ? (Float)((position.x + 32) >> 6) : position.x / 64.0f;
+    AppendGlyph(instances, chr, x + px * s, y + position.y / 64.0f * s, s,
+                color);
+  }
+}
+
+void TextBatch::Submit(TextLayout const &layout, Float const &x,
+                       Float const &y) {
+  Font *font = layout.GetFont();
+  if (font == nullptr) {
+    throw Exceptions::TextError("Font not loaded");
+    return;
+  }
+
+  Bool snap = font->GetRenderMode() == FontRenderMode::BITMAP;
+  Vec<GlyphInstance> &instances = this->AcquireBatch(font).instances;
+  for (auto const &glyph : layout.GetGlyphs()) {
+    // Loading marks the glyph used and brings it back after an eviction.
+    font->LoadCharacter(glyph.codepoint);
+    CharacterData const &chr = font->AcquireCharacter(glyph.codepoint);
+    if (chr.codepoint == 0) {
+      continue;
+    }
+
+    Float px = snap ? std::round(x + glyph.x) : x + glyph.x;
+    AppendGlyph(instances, chr, px, y + glyph.y, glyph.scale, glyph.color);
+  }
+}
+
+void TextBatch::Flush(Float const &windowWidth, Float const &windowHeight) {
+  if (!mShaderLoaded) {
+    throw Exceptions::TextError("Shader not loaded");
+    return;
+  }
+
+  Uint count = this->GetQuadCount();
+  if (count != 0) {
+    this->Draw(count, windowWidth, windowHeight);
+  }
+
+  // Background glyphs land here, so text made only of placeholders still
+  // appears on a later frame. The pin is released first, since this frame's
+  // glyphs are drawn.
+  for (auto &batch : mBatches) {
+    if (batch.submitted) {
+      batch.submitted = false;
+      batch.font->Unpin();
+      batch.font->Update();
+    }
+  }
+  this->Clear();
+}
+
+void TextBatch::Draw(Uint const &count, Float const &windowWidth,
+                     Float const &windowHeight) {
+  // Fonts are laid out back to back, so each atlas draws one instance range.
+  mInstances.clear();
+  for (auto const &batch : mBatches) {
+    mInstances.insert(mInstances.end(), batch.instances.begin(),
+                      batch.instances.end());
+  }
+
+  if (count > mInstanceCapacity) {
+    Uint capacity = std::max({count, mInstanceCapacity * 2, 64u});
+    if (mInstanceCapacity == 0) {
+      mBuffer.AllocateData((Ulong)capacity * sizeof(GlyphInstance),
+                           mAttributes, mLocations, BufferUsage::STREAM_DRAW);
+      for (auto const &[name, attribute] : mAttributes) {
+        mBuffer.SetAttributeDivisor(name, 1);
+      }
+    }
+    mInstanceCapacity = capacity;
+  }
+
+  // Respecifying the storage orphans last frame's instances, so the upload
+  // does not wait for draws still reading them.
+  mBuffer.ReallocateData(0, (Ulong)mInstanceCapacity * sizeof(GlyphInstance),
+                         BufferUsage::STREAM_DRAW);
+  mBuffer.ReloadData(mInstances, 0, mInstances.size());
+
+  mShader.Use();
+  Shader::ActivateTexture(TextureTargets::TEX_0);
+  mShader.SetInt(mTextureUniform, 0);
+  mShader.SetMat4(mTransformUniform,
+                  ortho(0.0f, windowWidth, 0.0f, windowHeight));
+
+  Ulong first = 0;
+  for (auto const &batch : mBatches) {
+    Ulong glyphs = batch.instances.size();
+    if (glyphs == 0) {
+      continue;
+    }
+
+    batch.font->Use();
+    mBuffer.DrawInstances(DrawMode::TRIANGLE_STRIP, sInstanceVertices, glyphs,
+                          first);
+    batch.font->Unuse();
+    first += glyphs;
+  }
+
+  mShader.Unuse();
+}
+
+void TextBatch::Clear() {
+  // Instance storage is kept so steady frames do not allocate.
+  for (auto &batch : mBatches) {
+    if (batch.submitted) {
+      batch.font->Unpin();
+    }
+    batch.submitted = false;
+    batch.instances.clear();
+  }
+}
 } // namespace TerreateGraphics::Core
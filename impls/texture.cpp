@@ -1,30 +1,100 @@
+#include "../includes/device.hpp"
 #include "../includes/exceptions.hpp"
 #include "../includes/texture.hpp"
 
+#include <algorithm>
+
 namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
 
-Texture::Texture(Uint const &width, Uint const &height, Uint const &layers)
-    : mSize({width, height}), mLayers(layers) {
+// Copies one level of every layer or face through a read framebuffer, for
+// contexts without ARB_copy_image. Destination must be bound to target.
+static void CopyLevelThroughFramebuffer(GLenum const &target, ID const &source,
+                                        Uint const &sourceLevel,
+                                        Uint const &destLevel,
+                                        Uint const &width, Uint const &height,
+                                        Uint const &depth) {
+  GLint previous = 0;
+  glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+  ID framebuffer = 0;
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  for (Uint z = 0; z < depth; ++z) {
+    if (target == GL_TEXTURE_CUBE_MAP) {
+      GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + z;
+      glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, face,
+                             source, sourceLevel);
+      glCopyTexSubImage2D(face, destLevel, 0, 0, 0, 0, width, height);
+    } else {
+      glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                source, sourceLevel, z);
+      glCopyTexSubImage3D(target, destLevel, 0, 0, z, 0, 0, width, height);
+    }
+  }
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+  glDeleteFramebuffers(1, &framebuffer);
+}
+
+// Allocates levels [evicted, levels) of a texture whose base level is size,
+// and copies the levels source and the new storage both hold. Returns an
+// empty texture name when every level is evicted.
+static ID AllocateLevels(GLenum const &target, ID const &source,
+                         TextureChannelType const &format,
+                         Pair<Uint> const &size, Uint const &depth,
+                         Uint const &levels, Uint const &sourceEvicted,
+                         Uint const &evicted, Uint const &copyDepth) {
+  ID texture = 0;
+  glGenTextures(1, &texture);
+  if (evicted >= levels) {
+    return texture;
+  }
+
+  Uint width = std::max(1u, size.first >> evicted);
+  Uint height = std::max(1u, size.second >> evicted);
+  glBindTexture(target, texture);
+  Texture::AllocateStorage(target, levels - evicted, format, width, height,
+                           depth);
+
+  Bool copyImage = GetDeviceCaps().copyImage;
+  for (Uint level = std::max(evicted, sourceEvicted);
+       copyDepth != 0 && level < levels; ++level) {
+    Uint levelWidth = std::max(1u, size.first >> level);
+    Uint levelHeight = std::max(1u, size.second >> level);
+    if (copyImage) {
+      glCopyImageSubData(source, target, level - sourceEvicted, 0, 0, 0,
+                         texture, target, level - evicted, 0, 0, 0, levelWidth,
+                         levelHeight, copyDepth);
+    } else {
+      CopyLevelThroughFramebuffer(target, source, level - sourceEvicted,
+                                  level - evicted, levelWidth, levelHeight,
+                                  copyDepth);
+    }
+  }
+  glBindTexture(target, 0);
+  return texture;
+}
+
+Texture::Texture(Uint const &width, Uint const &height, Uint const &layers,
+                 TextureChannelType const &format)
+    : mSize({width, height}), mFormat(format) {
   glGenTextures(1, mTexture);
+  mLayers->layers = layers;
 
   this->Bind();
-  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32F, mSize.first, mSize.second,
-                 layers);
-  this->SetFilter(mFilter.first, mFilter.second);
-  this->SetWrapping(mWrap.first, mWrap.second);
+  Texture::AllocateStorage(GL_TEXTURE_2D_ARRAY, mLevels, mFormat, mSize.first,
+                           mSize.second, layers);
   this->Unbind();
 }
 
-Texture::Texture(TextureSize const &size, Uint const &layers)
-    : mSize({(Uint)size, (Uint)size}), mLayers(layers) {
+Texture::Texture(TextureSize const &size, Uint const &layers,
+                 TextureChannelType const &format)
+    : mSize({(Uint)size, (Uint)size}), mFormat(format) {
   glGenTextures(1, mTexture);
+  mLayers->layers = layers;
 
   this->Bind();
-  glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA32F, mSize.first, mSize.second,
-                 layers);
-  this->SetFilter(mFilter.first, mFilter.second);
-  this->SetWrapping(mWrap.first, mWrap.second);
+  Texture::AllocateStorage(GL_TEXTURE_2D_ARRAY, mLevels, mFormat, mSize.first,
+                           mSize.second, layers);
   this->Unbind();
 }
 
@@ -36,24 +106,127 @@ Texture::~Texture() {
 }
 
 void Texture::SetFilter(FilterType const &min, FilterType const &mag) {
-  mFilter = {min, mag};
-  this->Bind();
-  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (GLenum)min);
-  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (GLenum)mag);
-  this->Unbind();
+  SamplerDescriptor descriptor = mSampler.GetDescriptor();
+  descriptor.minFilter = min;
+  descriptor.magFilter = mag;
+  this->SetSampler(descriptor);
 }
 
 void Texture::SetWrapping(WrappingType const &s, WrappingType const &t) {
-  mWrap = {s, t};
-  this->Bind();
-  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, (GLenum)s);
-  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, (GLenum)t);
-  this->Unbind();
+  SamplerDescriptor descriptor = mSampler.GetDescriptor();
+  descriptor.wrapS = s;
+  descriptor.wrapT = t;
+  this->SetSampler(descriptor);
+}
+
+void Texture::Bind(TextureTargets const &target,
+                   Sampler const &sampler) const {
+  glActiveTexture((GLenum)target);
+  Sampler::SetActiveUnit((GLenum)target - GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, (TCu32)mTexture);
+  sampler.Bind();
+}
+
+void Texture::MarkLayer(Uint const &layer) {
+  if (layer >= mLayers->usedLayers) {
+    this->Reserve(layer + 1);
+    for (Uint i = mLayers->usedLayers; i < layer; ++i) {
+      mLayers->freeLayers.push_back(i);
+    }
+    mLayers->usedLayers = layer + 1;
+    return;
+  }
+
+  Vec<Uint> &freeLayers = mLayers->freeLayers;
+  auto it = std::find(freeLayers.begin(), freeLayers.end(), layer);
+  if (it != freeLayers.end()) {
+    freeLayers.erase(it);
+  }
+}
+
+Uint Texture::AcquireLayer() {
+  Uint layer = this->GetCurrentLayer();
+  this->MarkLayer(layer);
+  return layer;
+}
+
+void Texture::ReleaseLayer(Str const &name) {
+  auto it = mLayers->textures.find(name);
+  if (it == mLayers->textures.end()) {
+    return;
+  }
+
+  Uint layer = it->second;
+  mLayers->textures.erase(it);
+  for (auto const &[other, index] : mLayers->textures) {
+    if (index == layer) {
+      return;
+    }
+  }
+  mLayers->freeLayers.push_back(layer);
+}
+
+void Texture::Reserve(Uint const &layers) {
+  if (layers <= mLayers->layers) {
+    return;
+  }
+
+  if (mSize.first == 0 || mSize.second == 0) {
+    throw Exceptions::TextureError("Texture storage is not allocated.");
+  }
+
+  Uint maxLayers = Texture::GetMaxLayers();
+  if (layers > maxLayers) {
+    throw Exceptions::TextureError("Texture layer limit exceeded.");
+  }
+
+  Uint newLayers = std::min(std::max(layers, mLayers->layers * 2), maxLayers);
+  this->Reallocate(newLayers, mLayers->evictedLevels);
+}
+
+void Texture::Reallocate(Uint const &layers, Uint const &evicted) {
+  ID texture = AllocateLevels(
+      GL_TEXTURE_2D_ARRAY, mTexture, mFormat, mSize, layers, mLevels,
+      mLayers->evictedLevels, evicted,
+      std::min(mLayers->usedLayers, mLayers->layers));
+  glDeleteTextures(1, mTexture);
+  mTexture.Ref() = texture;
+  mLayers->layers = layers;
+  mLayers->evictedLevels = evicted;
+}
+
+Size Texture::GetByteSize() const {
+  Size size = 0;
+  for (Uint level = mLayers->evictedLevels; level < mLevels; ++level) {
+    size += (Size)std::max(1u, mSize.first >> level) *
+            std::max(1u, mSize.second >> level);
+  }
+  return size * mLayers->layers * Texture::GetTexelSize(mFormat);
+}
+
+void Texture::Evict(Uint const &levels) {
+  Uint evicted = std::min(mLayers->evictedLevels + levels, mLevels);
+  if (evicted != mLayers->evictedLevels) {
+    this->Reallocate(mLayers->layers, evicted);
+  }
+}
+
+void Texture::Restore() {
+  if (mLayers->evictedLevels != 0) {
+    this->Reallocate(mLayers->layers, 0);
+  }
 }
 
 void Texture::LoadData(Str const &name, Uint width, Uint height, Uint channels,
                        Ubyte const *data) {
-  mTextures[name] = mTextures.size();
+  if (mLayers->evictedLevels != 0) {
+    throw Exceptions::TextureError("Texture is evicted.");
+    return;
+  }
+  auto it = mLayers->textures.find(name);
+  if (it == mLayers->textures.end()) {
+    mLayers->textures[name] = this->AcquireLayer();
+  }
 
   Uint format;
   switch (channels) {
@@ -78,8 +251,8 @@ void Texture::LoadData(Str const &name, Uint width, Uint height, Uint channels,
 
   this->Bind();
   glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, mSize.second - height,
-                  mTextures[name], width, height, 1, format, GL_UNSIGNED_BYTE,
-                  data);
+                  mLayers->textures[name], width, height, 1, format,
+                  GL_UNSIGNED_BYTE, data);
   glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
   this->Unbind();
@@ -89,7 +262,12 @@ void Texture::LoadDataAt(Str const &name, Uint const &xoffset,
                          Uint const &yoffset, Uint const &layer,
                          Uint const &width, Uint const &height,
                          Uint const &channels, Ubyte const *data) {
-  mTextures[name] = layer;
+  if (mLayers->evictedLevels != 0) {
+    throw Exceptions::TextureError("Texture is evicted.");
+    return;
+  }
+  this->MarkLayer(layer);
+  mLayers->textures[name] = layer;
 
   Uint format;
   switch (channels) {
@@ -120,21 +298,116 @@ void Texture::LoadDataAt(Str const &name, Uint const &xoffset,
   this->Unbind();
 }
 
-Uint Texture::GetMaxTextureSize() {
-  GLint size;
-  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
-  return size;
+void Texture::LoadRegions(Vec<TextureRegion> const &regions,
+                          Uint const &channels) {
+  if (regions.empty()) {
+    return;
+  }
+
+  GLenum format;
+  switch (channels) {
+  case 1:
+    format = GL_RED;
+    break;
+  case 2:
+    format = GL_RG;
+    break;
+  case 3:
+    format = GL_RGB;
+    break;
+  case 4:
+    format = GL_RGBA;
+    break;
+  default:
+    throw Exceptions::TextureError("Invalid number of channels.");
+  }
+
+  if (mLayers->evictedLevels != 0) {
+    throw Exceptions::TextureError("Texture is evicted.");
+    return;
+  }
+  for (auto const &region : regions) {
+    this->MarkLayer(region.layer);
+  }
+
+  this->Bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (auto const &region : regions) {
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, region.x, region.y, region.layer,
+                    region.width, region.height, 1, format, GL_UNSIGNED_BYTE,
+                    region.pixels);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  this->Unbind();
 }
 
+void Texture::AllocateStorage(GLenum const &target, Uint const &levels,
+                              TextureChannelType const &format,
+                              Uint const &width, Uint const &height,
+                              Uint const &depth) {
+  Bool flat = target == GL_TEXTURE_2D || target == GL_TEXTURE_CUBE_MAP;
+  if (GetDeviceCaps().textureStorage) {
+    if (flat) {
+      glTexStorage2D(target, levels, (GLenum)format, width, height);
+    } else {
+      glTexStorage3D(target, levels, (GLenum)format, width, height, depth);
+    }
+    return;
+  }
+
+  // Mutable storage needs every level specified and the level range clamped,
+  // otherwise the texture is incomplete.
+  for (Uint level = 0; level < levels; ++level) {
+    Uint levelWidth = std::max(1u, width >> level);
+    Uint levelHeight = std::max(1u, height >> level);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+      for (Uint face = 0; face < 6; ++face) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level,
+                     (GLenum)format, levelWidth, levelHeight, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+      }
+    } else if (flat) {
+      glTexImage2D(target, level, (GLenum)format, levelWidth, levelHeight, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    } else {
+      glTexImage3D(target, level, (GLenum)format, levelWidth, levelHeight,
+                   depth, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+  }
+  glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+Uint Texture::GetMaxTextureSize() { return GetDeviceCaps().maxTextureSize; }
+
 Uint Texture::GetMaxStorage() {
   GLuint size = Texture::GetMaxTextureSize();
   return size * size;
 }
 
-Uint Texture::GetMaxLayers() {
-  GLint layers;
-  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layers);
-  return layers;
+Uint Texture::GetMaxLayers() { return GetDeviceCaps().maxArrayTextureLayers; }
+
+Uint Texture::GetTexelSize(TextureChannelType const &format) {
+  switch (format) {
+  case TextureChannelType::R8:
+    return 1;
+  case TextureChannelType::RGBA:
+  case TextureChannelType::RGBA8:
+  case TextureChannelType::RGBA8UI:
+    return 4;
+  case TextureChannelType::RGBA16F:
+    return 8;
+  case TextureChannelType::RGBA32F:
+    return 16;
+  default:
+    return 4;
+  }
+}
+
+CubeTexture::CubeTexture(Uint const &size, TextureChannelType const &format)
+    : mFormat(format) {
+  glGenTextures(1, mTexture);
+  this->Allocate(size, size);
 }
 
 CubeTexture::~CubeTexture() {
@@ -144,30 +417,74 @@ CubeTexture::~CubeTexture() {
   }
 }
 
-void CubeTexture::SetFilter(FilterType const &filter) {
-  mFilter = filter;
+void CubeTexture::Allocate(Uint const &width, Uint const &height) {
+  if (mLevels != 0 && width == mWidth && height == mHeight) {
+    return;
+  }
+
+  if (mLevels != 0) {
+    // Immutable storage can not be resized, so swap in a new texture name.
+    ID texture = 0;
+    glGenTextures(1, &texture);
+    glDeleteTextures(1, mTexture);
+    mTexture.Ref() = texture;
+  }
+
+  mWidth = width;
+  mHeight = height;
+  mLevels = CubeTexture::GetMipLevels(std::max(width, height));
+  mEvictedLevels = 0;
+
   this->Bind();
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (GLenum)mFilter);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, (GLenum)mFilter);
+  Texture::AllocateStorage(GL_TEXTURE_CUBE_MAP, mLevels, mFormat, mWidth,
+                           mHeight, 6);
   this->Unbind();
 }
 
+void CubeTexture::SetFilter(FilterType const &filter) {
+  FilterType mag = filter;
+  switch (filter) {
+  case FilterType::NEAREST_MIPMAP_NEAREST:
+  case FilterType::NEAREST_MIPMAP_LINEAR:
+    mag = FilterType::NEAREST;
+    break;
+  case FilterType::LINEAR_MIPMAP_NEAREST:
+  case FilterType::LINEAR_MIPMAP_LINEAR:
+    mag = FilterType::LINEAR;
+    break;
+  default:
+    break;
+  }
+  this->SetFilter(filter, mag);
+}
+
+void CubeTexture::SetFilter(FilterType const &min, FilterType const &mag) {
+  SamplerDescriptor descriptor = mSampler.GetDescriptor();
+  descriptor.minFilter = min;
+  descriptor.magFilter = mag;
+  this->SetSampler(descriptor);
+}
+
 void CubeTexture::SetWrapping(WrappingType const &wrap) {
-  mWrap = wrap;
-  this->Bind();
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, (GLenum)mWrap);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, (GLenum)mWrap);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, (GLenum)mWrap);
-  this->Unbind();
+  SamplerDescriptor descriptor = mSampler.GetDescriptor();
+  descriptor.wrapS = wrap;
+  descriptor.wrapT = wrap;
+  descriptor.wrapR = wrap;
+  this->SetSampler(descriptor);
+}
+
+void CubeTexture::Bind(TextureTargets const &target,
+                       Sampler const &sampler) const {
+  glActiveTexture((GLenum)target);
+  Sampler::SetActiveUnit((GLenum)target - GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_CUBE_MAP, mTexture);
+  sampler.Bind();
 }
 
 void CubeTexture::LoadData(CubeFace face, Uint width, Uint height,
                            Uint channels, Ubyte const *data) {
-  mWidth = width;
-  mHeight = height;
-  mChannels = channels;
   GLenum format;
-  switch (mChannels) {
+  switch (channels) {
   case 1:
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     format = GL_RED;
@@ -177,7 +494,7 @@ void CubeTexture::LoadData(CubeFace face, Uint width, Uint height,
     format = GL_RG;
     break;
   case 3:
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 3);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     format = GL_RGB;
     break;
   case 4:
@@ -193,12 +510,16 @@ void CubeTexture::LoadData(CubeFace face, Uint width, Uint height,
     return;
   }
 
+  mChannels = channels;
+  this->Allocate(width, height);
+  if (mEvictedLevels != 0) {
+    throw Exceptions::TextureError("Texture is evicted.");
+    return;
+  }
   this->Bind();
-  glTexImage2D((GLenum)face, 0, GL_RGBA, mWidth, mHeight, 0, format,
-               GL_UNSIGNED_BYTE, data);
+  glTexSubImage2D((GLenum)face, 0, 0, 0, mWidth, mHeight, format,
+                  GL_UNSIGNED_BYTE, data);
   glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-  this->SetFilter(mFilter);
-  this->SetWrapping(mWrap);
   this->Unbind();
 }
 
@@ -206,5 +527,60 @@ void CubeTexture::LoadDatas(Vec<TextureData> const &datas) {
   for (Uint i = 0; i < datas.size(); ++i) {
     this->LoadData((CubeFace)((GLenum)CubeFace::RIGHT + i), datas[i]);
   }
+  this->GenerateMipmaps();
+}
+
+void CubeTexture::GenerateMipmaps() const {
+  if (mLevels <= 1) {
+    return;
+  }
+
+  this->Bind();
+  glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+  this->Unbind();
+}
+
+Size CubeTexture::GetByteSize() const {
+  Size size = 0;
+  for (Uint level = mEvictedLevels; level < mLevels; ++level) {
+    size += (Size)std::max(1u, mWidth >> level) *
+            std::max(1u, mHeight >> level);
+  }
+  return size * 6 * Texture::GetTexelSize(mFormat);
+}
+
+void CubeTexture::Evict(Uint const &levels) {
+  Uint evicted = std::min(mEvictedLevels + levels, mLevels);
+  if (evicted == mEvictedLevels) {
+    return;
+  }
+
+  ID texture = AllocateLevels(GL_TEXTURE_CUBE_MAP, mTexture, mFormat,
+                              {mWidth, mHeight}, 6, mLevels, mEvictedLevels,
+                              evicted, 6);
+  glDeleteTextures(1, mTexture);
+  mTexture.Ref() = texture;
+  mEvictedLevels = evicted;
+}
+
+void CubeTexture::Restore() {
+  if (mEvictedLevels == 0) {
+    return;
+  }
+
+  ID texture = AllocateLevels(GL_TEXTURE_CUBE_MAP, mTexture, mFormat,
+                              {mWidth, mHeight}, 6, mLevels, mEvictedLevels, 0,
+                              6);
+  glDeleteTextures(1, mTexture);
+  mTexture.Ref() = texture;
+  mEvictedLevels = 0;
+}
+
+Uint CubeTexture::GetMipLevels(Uint const &size) {
+  Uint levels = 1u;
+  while ((size >> levels) > 0) {
+    ++levels;
+  }
+  return levels;
 }
 } // namespace TerreateGraphics::Core
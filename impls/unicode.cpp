@@ -0,0 +1,157 @@
+#include "../includes/unicode.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+namespace Unicode {
+static Bool IsContinuation(Ubyte const &byte) { return (byte & 0xC0) == 0x80; }
+
+// Widens the leading run of ASCII bytes, 16 at a time. Returns the number
+// of bytes consumed, which is a multiple of the block size.
+static Size WidenASCII(Ubyte const *src, Size const &size, wchar_t *dst) {
+  Size i = 0;
+#if defined(__SSE2__)
+  __m128i const zero = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes = _mm_loadu_si128((__m128i const *)(src + i));
+    if (_mm_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    if constexpr (sizeof(wchar_t) == 2) {
+      _mm_storeu_si128((__m128i *)(dst + i), lo);
+      _mm_storeu_si128((__m128i *)(dst + i + 8), hi);
+    } else {
+      __m128i *out = (__m128i *)(dst + i);
+      _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+    }
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t bytes = vld1q_u8(src + i);
+    uint64x2_t high = vreinterpretq_u64_u8(vshrq_n_u8(bytes, 7));
+    if ((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) != 0) {
+      break;
+    }
+    uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+    if constexpr (sizeof(wchar_t) == 2) {
+      vst1q_u16((uint16_t *)(dst + i), lo);
+      vst1q_u16((uint16_t *)(dst + i + 8), hi);
+    } else {
+      uint32_t *out = (uint32_t *)(dst + i);
+      vst1q_u32(out, vmovl_u16(vget_low_u16(lo)));
+      vst1q_u32(out + 4, vmovl_u16(vget_high_u16(lo)));
+      vst1q_u32(out + 8, vmovl_u16(vget_low_u16(hi)));
+      vst1q_u32(out + 12, vmovl_u16(vget_high_u16(hi)));
+    }
+  }
+#else
+  for (; i + 8 <= size; i += 8) {
+    Ulong word = 0;
+    std::memcpy(&word, src + i, sizeof(word));
+    if ((word & 0x8080808080808080ull) != 0) {
+      break;
+    }
+    for (Size k = 0; k < 8; ++k) {
+      dst[i + k] = src[i + k];
+    }
+  }
+#endif
+  return i;
+}
+
+Bool DecodeCodepoint(char const *src, Size const &size, Uint &codepoint,
+                     Size &length) {
+  Ubyte const *bytes = reinterpret_cast<Ubyte const *>(src);
+  Ubyte lead = bytes[0];
+  length = 1;
+  if (lead < 0x80) {
+    codepoint = lead;
+    return true;
+  }
+
+  Size expected = 0;
+  Uint minimum = 0;
+  if ((lead & 0xE0) == 0xC0) {
+    expected = 2;
+    minimum = 0x80;
+    codepoint = lead & 0x1F;
+  } else if ((lead & 0xF0) == 0xE0) {
+    expected = 3;
+    minimum = 0x800;
+    codepoint = lead & 0x0F;
+  } else if ((lead & 0xF8) == 0xF0) {
+    expected = 4;
+    minimum = 0x10000;
+    codepoint = lead & 0x07;
+  } else {
+    codepoint = sReplacementCharacter;
+    return false;
+  }
+
+  for (; length < expected; ++length) {
+    if (length >= size || !IsContinuation(bytes[length])) {
+      codepoint = sReplacementCharacter;
+      return false;
+    }
+    codepoint = (codepoint << 6) | (bytes[length] & 0x3F);
+  }
+
+  if (codepoint < minimum || codepoint > 0x10FFFF ||
+      (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+    codepoint = sReplacementCharacter;
+    return false;
+  }
+  return true;
+}
+
+Bool DecodeUTF8(char const *src, Size const &size, WStr &dst) {
+  // Every byte yields at most one character.
+  dst.resize(size);
+  Ubyte const *bytes = reinterpret_cast<Ubyte const *>(src);
+  wchar_t *out = dst.data();
+  Bool valid = true;
+  Size count = 0;
+  Size i = 0;
+  while (i < size) {
+    Size ascii = WidenASCII(bytes + i, size - i, out + count);
+    i += ascii;
+    count += ascii;
+
+    // Finish the block that ended the fast path one character at a time.
+    for (Size end = std::min(size, i + 16); i < end;) {
+      if (bytes[i] < 0x80) {
+        out[count++] = bytes[i++];
+        continue;
+      }
+
+      Uint codepoint = 0;
+      Size length = 0;
+      valid = DecodeCodepoint(src + i, size - i, codepoint, length) && valid;
+      if (sizeof(wchar_t) == 2 && codepoint > 0xFFFF) {
+        codepoint = sReplacementCharacter;
+      }
+      out[count++] = (wchar_t)codepoint;
+      i += length;
+    }
+  }
+  dst.resize(count);
+  return valid;
+}
+} // namespace Unicode
+} // namespace TerreateGraphics::Core
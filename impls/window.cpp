@@ -1,3 +1,4 @@
+#include "../includes/device.hpp"
 #include "../includes/exceptions.hpp"
 #include "../includes/window.hpp"
 
@@ -153,7 +154,7 @@ Window::Window(Uint const &width, Uint const &height, Str const &title,
   glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, settings.transparentFramebuffer);
   glfwWindowHint(GLFW_FOCUS_ON_SHOW, settings.focusOnShow);
   glfwWindowHint(GLFW_SCALE_TO_MONITOR, settings.scaleToMonitor);
-  mWindow = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
+  mWindow = CreateContextWindow(width, height, title);
   glfwSetWindowUserPointer(mWindow, this);
 
   glfwMakeContextCurrent(mWindow);
@@ -163,6 +164,7 @@ Window::Window(Uint const &width, Uint const &height, Str const &title,
       throw Exceptions::GraphicsException("Failed to initialize GLAD.");
     }
     GLAD_INITIALIZED = true;
+    LoadDeviceCaps();
   }
 
   glfwSetWindowPosCallback(mWindow, Callbacks::WindowPositionCallbackWrapper);
@@ -5,12 +5,19 @@
 #include "compute.hpp"
 #include "converter.hpp"
 #include "defines.hpp"
+#include "device.hpp"
 #include "font.hpp"
+#include "imageops.hpp"
 #include "joystick.hpp"
+#include "layout.hpp"
+#include "programcache.hpp"
+#include "residency.hpp"
+#include "sampler.hpp"
 #include "screen.hpp"
 #include "shader.hpp"
 #include "text.hpp"
 #include "texture.hpp"
+#include "unicode.hpp"
 #include "window.hpp"
 
 namespace TerreateGraphics::Core {
@@ -43,7 +50,11 @@ public:
   static Double GetCurrentRuntime() { return glfwGetTime(); }
 };
 
-void Initialize();
+/*
+ * @brief: Initializes GLFW.
+ * @param: settings: OpenGL context settings used for new windows
+ */
+void Initialize(ContextSettings const &settings = ContextSettings());
 void Terminate();
 } // namespace TerreateGraphics::Core
 #endif // __TERREATE_GRAPHICS_TERREATEGRAPHICS_HPP__
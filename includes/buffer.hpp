@@ -18,6 +18,8 @@ struct AttributeData {
   Ulong size;
   Ulong stride;
   Ulong offset;
+  AttributeType type = AttributeType::FLOAT;
+  Bool normalized = false; // map integers to [0, 1] or [-1, 1]
 };
 
 class BufferDataConstructor {
@@ -92,6 +94,10 @@ private:
   Vec<GLObject> mBuffers;
   Map<Str, AttributeData> mAttributes;
 
+private:
+  void ReloadBytes(void const *data, Ulong const &offset, Ulong const &size,
+                   Ulong const &vboIndex);
+
 public:
   /*
    * @brief: Construct a new Buffer object
@@ -134,6 +140,46 @@ public:
   void LoadData(BufferDataConstructor const &bdc,
                 Map<Str, Uint> const &locations,
                 BufferUsage const &usage = BufferUsage::STATIC_DRAW);
+  /*
+   * @brief: Allocate uninitialized vertex storage
+   * @param: size: Size in bytes
+   * @param: attrs: Attributes to load
+   * @param: locations: Locations to load
+   * @param: usage: Buffer usage
+   * @detail: Creates one vertex buffer. Fill it with ReloadData and grow it
+   * with ReallocateData, which keep the same OpenGL buffer.
+   */
+  void AllocateData(Ulong const &size, Map<Str, AttributeData> const &attrs,
+                    Map<Str, Uint> const &locations,
+                    BufferUsage const &usage = BufferUsage::DYNAMIC_DRAW);
+  /*
+   * @brief: Resize vertex storage in place
+   * @param: vboIndex: Index of the vertex buffer
+   * @param: size: New size in bytes
+   * @param: usage: Buffer usage
+   * @detail: Contents become undefined. The OpenGL buffer and attribute
+   * bindings are kept, so no object is created.
+   */
+  void ReallocateData(Ulong const &vboIndex, Ulong const &size,
+                      BufferUsage const &usage = BufferUsage::DYNAMIC_DRAW);
+  /*
+   * @brief: Reload a range of raw data into the buffer
+   * @param: raw: Raw data mirrored by the vertex buffer
+   * @param: first: First element to upload
+   * @param: count: Number of elements to upload
+   * @param: vboIndex: Index of the vertex buffer
+   * @detail: raw[first] is written at byte offset first * sizeof(T).
+   */
+  template <typename T>
+  void ReloadData(Vec<T> const &raw, Ulong const &first, Ulong const &count,
+                  Ulong const &vboIndex = 0u) {
+    if (first + count > raw.size()) {
+      throw Exceptions::BufferError("Data range out of bounds.");
+    }
+
+    this->ReloadBytes(raw.data() + first, first * sizeof(T),
+                      count * sizeof(T), vboIndex);
+  }
   /*
    * @brief: Reload data into the buffer
    * @param: target: Target buffer
@@ -170,6 +216,7 @@ public:
   /*
    * @brief: Load indices into the buffer
    * @param: indices: Indices to load
+   * @detail: The index buffer is created once and reused by later loads.
    */
   void LoadIndices(Vec<Uint> const &indices);
   /*
@@ -191,6 +238,11 @@ public:
   void ReloadIndices(Vec<Vec<Uint>> const &indices) {
     this->ReloadIndices(Buffer::Flatten(indices));
   }
+  /*
+   * @brief: Set number of indices to draw
+   * @param: count: Number of indices, at most the number loaded
+   */
+  void SetIndexCount(Ulong const &count) { mIndexCount = count; }
   /*
    * @brief: Bind the buffer
    */
@@ -210,6 +262,20 @@ public:
    * @param: count: Number of instances to draw
    */
   void Draw(DrawMode const &mode, Ulong const &count) const;
+  /*
+   * @brief: Draw instances without indices
+   * @param: mode: Mode to draw
+   * @param: vertexCount: Number of vertices per instance
+   * @param: instanceCount: Number of instances to draw
+   * @param: firstInstance: First instance to draw
+   * @detail: Vertices carry no attributes of their own. The vertex shader
+   * builds them from gl_VertexID and per instance attributes, which are set
+   * up with SetAttributeDivisor. A first instance other than 0 needs OpenGL
+   * 4.2.
+   */
+  void DrawInstances(DrawMode const &mode, Ulong const &vertexCount,
+                     Ulong const &instanceCount,
+                     Ulong const &firstInstance = 0u) const;
 
   AttributeData &operator[](Str const &name) { return mAttributes[name]; }
   AttributeData &operator[](char const *name) { return mAttributes[name]; }
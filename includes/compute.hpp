@@ -15,6 +15,8 @@ class ComputeKernel final : public TerreateObjectBase {
 private:
   Bool mCompiled = false;
   Bool mLinked = false;
+  Bool mBinaryLoaded = false;
+  Ulong mCacheKey = 0u;
   GLObject mKernelID = GLObject();
   Str mKernelSource = "";
 
@@ -192,6 +194,23 @@ public:
    * @param: texture: texture to bind
    */
   void BindWriteImage(Str const &name, Texture const &texture) const;
+  /*
+   * @brief: This function binds texture as write only image of given format.
+   * @param: name: name of image uniform
+   * @param: texture: texture to bind
+   * @param: format: image format, same texel size as texture format
+   * @detail: RGBA8 textures bound as RGBA8UI take integer bytes unchanged.
+   */
+  void BindWriteImage(Str const &name, Texture const &texture,
+                      TextureChannelType const &format) const;
+  /*
+   * @brief: This function binds all faces of cube texture level as image.
+   * @param: name: name of image uniform
+   * @param: texture: cube texture to bind
+   * @param: level: mip level to bind
+   */
+  void BindWriteImage(Str const &name, CubeTexture const &texture,
+                      Uint const &level) const;
 
   /*
    * @brief: Compile shader.
@@ -1,32 +1,142 @@
 #ifndef __TERREATE_GRAPHICS_CONVERTER_HPP__
 #define __TERREATE_GRAPHICS_CONVERTER_HPP__
 
+#include "buffer.hpp"
 #include "compute.hpp"
 #include "defines.hpp"
+#include "imageops.hpp"
 #include "texture.hpp"
 
 namespace TerreateGraphics::Compute {
 using namespace TerreateGraphics::Defines;
 using namespace TerreateGraphics::Compute;
 
+namespace StagingPool {
+/*
+ * @brief: Acquires shared 2D staging texture large enough for image.
+ * @param: width: The width of the image
+ * @param: height: The height of the image
+ * @param: format: The internal format of the staging texture
+ * @return: staging texture
+ * @detail: Sizes are rounded up to power of two buckets, so one texture
+ * serves every image of similar size. Textures are shared by all converters
+ * and kept while they fit the pool budget.
+ */
+GLObject Acquire(Uint const &width, Uint const &height,
+                 TextureChannelType const &format);
+/*
+ * @brief: Acquires shared 2D array staging texture large enough for images.
+ * @param: width: The largest width of the images
+ * @param: height: The largest height of the images
+ * @param: layers: The number of images
+ * @param: format: The internal format of the staging texture
+ * @return: staging array texture
+ */
+GLObject AcquireArray(Uint const &width, Uint const &height,
+                      Uint const &layers, TextureChannelType const &format);
+/*
+ * @brief: Getter for GPU memory held by pooled staging textures.
+ * @return: size in bytes
+ */
+Size GetByteSize();
+/*
+ * @brief: Getter for GPU memory budget of the pool.
+ * @return: budget in bytes
+ */
+Size const &GetBudget();
+/*
+ * @brief: Setter for GPU memory budget of the pool.
+ * @param: budget: budget in bytes (default 64 MiB)
+ * @detail: The pool is trimmed to the new budget immediately.
+ */
+void SetBudget(Size const &budget);
+/*
+ * @brief: Releases least recently acquired textures until the pool fits
+ * its budget.
+ * @detail: Converters call this after every conversion, once their staging
+ * textures are no longer in use. A texture larger than the budget is
+ * released right after the conversion that needed it.
+ */
+void Trim();
+/*
+ * @brief: Releases every pooled staging texture.
+ * @detail: Called by Terminate while OpenGL context is still alive.
+ */
+void Clear();
+} // namespace StagingPool
+
+struct ConvertRequest {
+  Str name;
+  Uint layer = 0u;
+  Uint width = 0u;
+  Uint height = 0u;
+  Uint channels = 0u;
+  Ubyte const *pixels = nullptr;
+};
+
 class ImageConverter final : public TerreateObjectBase {
+private:
+  struct LayerInfo {
+    Float inputSize[2];
+    Int layer;
+    Int padding;
+  };
+
 private:
   static Uint const sKernelInputSize = 16;
+  static Uint const sResampleGroupSize = 64;
+  static Uint const sResampleTileSize = 1024;
+  static Size const sBatchByteBudget = 256ull << 20;
   static Str const sKernelSource;
+  static Str const sBatchKernelSource;
+  static Str const sResampleKernelSource;
+  static Str const sHorizontalKernelSource;
+  static Str const sVerticalKernelSource;
+  static Str const sVerticalByteKernelSource;
 
 private:
-  GLObject mInputTexture;
+  ResampleFilter mFilter = ResampleFilter::BILINEAR;
+  Bool mCompute = false;
   ComputeKernel mKernel;
+  ComputeKernel mBatchKernel;
+  ComputeKernel mHorizontalKernel;
+  ComputeKernel mVerticalKernel;
+  ComputeKernel mVerticalByteKernel;
+  ShaderStorageBuffer mLayerInfos;
+  ShaderStorageBuffer mFilterFirsts;
+  ShaderStorageBuffer mFilterWeights;
 
 private:
-  void CreateInputTexture();
+  void DispatchBatch(ConvertRequest const *requests, Uint const &count,
+                     Uint const &width, Uint const &height, Texture &storage);
+  void Resample(GLObject const &input, Uint const &width, Uint const &height,
+                Uint const &channels, Uint const &index, Texture &storage);
 
 public:
   /*
    * @brief Construct a new Image Converter object
+   * @detail: Kernels are compiled only when device tier is COMPUTE or above.
+   * On LEGACY contexts images are resampled by ImageOps::Resample and
+   * uploaded. Separable filters give the same bytes either way.
    */
   ImageConverter();
-  ~ImageConverter();
+  ~ImageConverter() {}
+
+  /*
+   * @brief: Getter for resampling filter
+   * @return: The resampling filter
+   */
+  ResampleFilter const &GetFilter() const { return mFilter; }
+
+  /*
+   * @brief: Setter for resampling filter
+   * @param: filter: The resampling filter
+   * @detail: BILINEAR does one hardware fetch per texel. Other filters run
+   * two separable passes whose 8 bit result is bit identical to
+   * ImageOps::Resample. RGBA8 storage receives exactly those bytes, other
+   * formats receive them as normalized values.
+   */
+  void SetFilter(ResampleFilter const &filter) { mFilter = filter; }
 
   /*
    * @brief: Stretch the image data to a texture
@@ -52,6 +162,66 @@ public:
   void Convert(Str const &name, Uint const &index, Uint const &width,
                Uint const &height, Uint const &channels, Ubyte const *pixels,
                Texture &storage);
+  /*
+   * @brief: Stretch many images to their layers of texture
+   * @param: requests: The images and their target layers
+   * @param: storage: The texture to store the data
+   * @detail: Images are packed into a staging array texture and resampled by
+   * one dispatch per chunk, where z is the image. Chunks are split by layer
+   * limit and staging memory budget.
+   */
+  void ConvertBatch(Vec<ConvertRequest> const &requests, Texture &storage);
+};
+
+class EquirectangularConverter final : public TerreateObjectBase {
+private:
+  static Uint const sKernelInputSize = 16;
+  static Str const sProjectionKernelSource;
+  static Str const sPrefilterKernelSource;
+
+private:
+  GLObject mInputTexture;
+  Uint mInputWidth = 0u;
+  Uint mInputHeight = 0u;
+  ComputeKernel mProjectionKernel;
+  ComputeKernel mPrefilterKernel;
+
+private:
+  void CreateInputTexture(Uint const &width, Uint const &height);
+  void Project(CubeTexture &storage);
+
+public:
+  /*
+   * @brief: Construct a new Equirectangular Converter object
+   */
+  EquirectangularConverter();
+  ~EquirectangularConverter();
+
+  /*
+   * @brief: Project equirectangular image onto every face of cube texture
+   * and prefilter its mip chain.
+   * @param: width: The width of the image
+   * @param: height: The height of the image
+   * @param: channels: The number of channels in the image
+   * @param: pixels: The HDR pixel data of the image
+   * @param: storage: The cube texture to store the data
+   * @detail: storage should be created with its size and format, e.g.
+   * CubeTexture(512, TextureChannelType::RGBA16F). First row of image is
+   * treated as the top of the sphere.
+   */
+  void Convert(Uint const &width, Uint const &height, Uint const &channels,
+               Float const *pixels, CubeTexture &storage);
+  /*
+   * @brief: Project equirectangular image onto every face of cube texture
+   * and prefilter its mip chain.
+   * @param: width: The width of the image
+   * @param: height: The height of the image
+   * @param: channels: The number of channels in the image
+   * @param: pixels: The pixel data of the image
+   * @param: storage: The cube texture to store the data
+   */
+  void Convert(Uint const &width, Uint const &height, Uint const &channels,
+               Ubyte const *pixels, CubeTexture &storage);
 };
 } // namespace TerreateGraphics::Compute
 
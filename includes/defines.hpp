@@ -36,6 +36,7 @@ typedef std::ofstream OutputFileStream;
 template <typename T> using Shared = std::shared_ptr<T>;
 template <typename... EventArgs>
 using Event = TerreateCore::Utils::Event<EventArgs...>;
+typedef TerreateCore::Utils::Executor Executor;
 
 // Callbacks
 using ErrorCallback = std::function<void(int errorCode, char const *message)>;
@@ -79,6 +80,18 @@ enum class Attachment {
   COLOR31 = GL_COLOR_ATTACHMENT31
 };
 
+// Use to select opengl vertex attribute component type.
+enum class AttributeType {
+  BYTE = GL_BYTE,
+  FLOAT = GL_FLOAT,
+  HALF_FLOAT = GL_HALF_FLOAT,
+  INT = GL_INT,
+  SHORT = GL_SHORT,
+  UNSIGNED_BYTE = GL_UNSIGNED_BYTE,
+  UNSIGNED_INT = GL_UNSIGNED_INT,
+  UNSIGNED_SHORT = GL_UNSIGNED_SHORT
+};
+
 // Use to select buffer to clear.
 enum class BufferBit {
   DEPTH_BUFFER = GL_DEPTH_BUFFER_BIT,
@@ -127,6 +140,13 @@ enum class BlendingFunction {
 // Use to select material color property.
 enum class ColorProperty { AMBIENT, DIFFUSE, SPECULAR, EMISSIVE };
 
+// Use to select opengl context profile.
+enum class ContextProfile {
+  ANY = GLFW_OPENGL_ANY_PROFILE,
+  CORE = GLFW_OPENGL_CORE_PROFILE,
+  COMPATIBILITY = GLFW_OPENGL_COMPAT_PROFILE
+};
+
 // Use to select opengl cube map face direction.
 enum class CubeFace {
   RIGHT = GL_TEXTURE_CUBE_MAP_POSITIVE_X,
@@ -196,6 +216,13 @@ enum class DrawMode {
   QUADS = GL_QUADS
 };
 
+// Use to check which rendering paths the device supports.
+enum class FeatureTier {
+  LEGACY,  // OpenGL 3.3, no compute shaders
+  COMPUTE, // OpenGL 4.3 or compute, storage buffers and copy image
+  MODERN   // Compute tier with buffer storage and direct state access
+};
+
 // Use to select opengl texture filtering type.
 enum class FilterType {
   NEAREST = GL_NEAREST,
@@ -214,6 +241,9 @@ enum class FloatProperty {
   REFRACTIVITY
 };
 
+// Use to select how font glyphs are rasterized.
+enum class FontRenderMode { BITMAP, SDF };
+
 // Use to select opengl error.
 enum class GLError {
   NO_ERROR = GL_NO_ERROR,
@@ -500,6 +530,9 @@ enum class StencilOperation {
   INVERT = GL_INVERT
 };
 
+// Use to select horizontal alignment of laid out text lines.
+enum class TextAlignment { CENTER, LEFT, RIGHT };
+
 enum class TextureChannelType {
   /* RED = GL_RED, */
   /* R16F = GL_R16F, */
@@ -510,7 +543,10 @@ enum class TextureChannelType {
   /* RGB = GL_RGB, */
   /* RGB16F = GL_RGB16F, */
   /* RGB32F = GL_RGB32F, */
+  R8 = GL_R8,
   RGBA = GL_RGBA,
+  RGBA8 = GL_RGBA8,
+  RGBA8UI = GL_RGBA8UI,
   RGBA16F = GL_RGBA16F,
   RGBA32F = GL_RGBA32F
 };
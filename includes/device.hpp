@@ -0,0 +1,108 @@
+#ifndef __TERREATE_GRAPHICS_DEVICE_HPP__
+#define __TERREATE_GRAPHICS_DEVICE_HPP__
+
+#include "defines.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+struct ContextSettings {
+public:
+  Uint major = 4u;
+  Uint minor = 6u;
+  ContextProfile profile = ContextProfile::CORE;
+  Bool forwardCompatible = false;
+  Bool debug = false;
+  // Versions tried in order when requested version is not available.
+  Vec<Pair<Uint>> fallbacks = {{4u, 5u}, {4u, 3u}, {4u, 1u}, {3u, 3u}};
+};
+
+struct DeviceCaps {
+public:
+  Uint major = 0u;
+  Uint minor = 0u;
+  Str vendor = "";
+  Str renderer = "";
+  Str version = "";
+  Str shadingLanguageVersion = "";
+  Set<Str> extensions = Set<Str>();
+
+  Uint maxTextureSize = 0u;
+  Uint maxArrayTextureLayers = 0u;
+  Uint maxCubeMapTextureSize = 0u;
+  Uint maxTextureImageUnits = 0u;
+  Uint maxCombinedTextureImageUnits = 0u;
+  Uint maxImageUnits = 0u;
+  Uint maxUniformBlockSize = 0u;
+  Uint maxShaderStorageBlockSize = 0u;
+  Uint maxComputeSharedMemorySize = 0u;
+  Uint maxComputeWorkGroupInvocations = 0u;
+  Uint maxComputeWorkGroupCount[3] = {0u, 0u, 0u};
+  Float maxAnisotropy = 1.0f;
+
+  Bool compute = false;
+  Bool textureStorage = false;
+  Bool copyImage = false;
+  Bool bufferStorage = false;
+  Bool directStateAccess = false;
+  Bool multiDrawIndirect = false;
+  Bool parallelShaderCompile = false;
+  Bool programBinary = false;
+  Bool anisotropy = false;
+  FeatureTier tier = FeatureTier::LEGACY;
+
+public:
+  /*
+   * @brief: Checks whether version is at least given version.
+   * @param: major: major version
+   * @param: minor: minor version
+   * @return: true if context version is at least major.minor
+   */
+  Bool IsVersion(Uint const &major, Uint const &minor) const {
+    return this->major > major ||
+           (this->major == major && this->minor >= minor);
+  }
+  /*
+   * @brief: Checks whether extension is supported.
+   * @param: name: extension name (e.g. "GL_ARB_buffer_storage")
+   * @return: true if extension is supported
+   */
+  Bool HasExtension(Str const &name) const {
+    return extensions.find(name) != extensions.end();
+  }
+};
+
+/*
+ * @brief: Getter for context settings used to create windows.
+ * @return: context settings
+ */
+ContextSettings const &GetContextSettings();
+/*
+ * @brief: Setter for context settings used to create windows.
+ * @param: settings: context settings
+ * @detail: Initialize sets this. Windows created afterwards use it.
+ */
+void SetContextSettings(ContextSettings const &settings);
+/*
+ * @brief: Creates glfw window with best available context version.
+ * @param: width: window width
+ * @param: height: window height
+ * @param: title: window title
+ * @return: glfw window
+ * @detail: Requested version is tried first, then every fallback below it.
+ */
+GLFWwindow *CreateContextWindow(Uint const &width, Uint const &height,
+                                Str const &title);
+/*
+ * @brief: Queries capabilities of current context.
+ * @detail: Called once after GLAD is loaded.
+ */
+void LoadDeviceCaps();
+/*
+ * @brief: Getter for cached capabilities of current context.
+ * @return: device capabilities
+ */
+DeviceCaps const &GetDeviceCaps();
+} // namespace TerreateGraphics::Core
+
+#endif // __TERREATE_GRAPHICS_DEVICE_HPP__
@@ -11,46 +11,437 @@ namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
 
 struct CharacterData {
-  Uint codepoint;
-  Pair<Uint> size;
-  Pair<Uint> bearing;
-  Long advance;
-  Vec<Float> uv; // {x0, y0, x1, y1, z}
+  Uint codepoint = 0u;
+  Int layer = -1; // atlas layer, -1 if glyph has no atlas region
+  Pair<Uint> size = {0u, 0u};
+  Pair<Int> bearing = {0, 0};
+  Long advance = 0;
+  Float uv[4] = {0.0f, 0.0f, 0.0f, 0.0f}; // {x0, y0, x1, y1}
 };
 
-class Font : public TerreateObjectBase {
+struct GlyphPosition {
+  CharacterData const *character = nullptr;
+  Long x = 0; // pen position in 26.6 fixed point
+  Long y = 0;
+};
+
+struct GlyphBitmap {
+  Uint codepoint = 0u;
+  Pair<Uint> size = {0u, 0u};
+  Pair<Int> bearing = {0, 0};
+  Long advance = 0;
+  Vec<Ubyte> pixels = Vec<Ubyte>();
+};
+
+struct GlyphJobs;
+class MappedFile;
+
+class GlyphTable final : public TerreateObjectBase {
+private:
+  struct Slot {
+    Uint codepoint;
+    Uint index;
+  };
+
+private:
+  static Uint const sDirectSize = 512u;
+  static Uint const sEmpty = ~0u;
+  static Uint const sTombstone = ~0u - 1u;
+
 private:
+  Vec<CharacterData> mGlyphs = Vec<CharacterData>();
+  Vec<Uint> mCodepoints = Vec<Uint>();
+  Vec<Uint> mUses = Vec<Uint>();
+  Vec<Uint> mDirect = Vec<Uint>(sDirectSize, sEmpty);
+  Vec<Slot> mSlots = Vec<Slot>();
+  Size mOccupied = 0u;
+  Size mHashed = 0u;
+
+private:
+  static Size Hash(Uint const &codepoint) {
+    return ((Ulong)codepoint * 0x9E3779B97F4A7C15ull) >> 32;
+  }
+  Size Probe(Uint const &codepoint) const;
+  Uint Locate(Uint const &codepoint) const {
+    if (codepoint < sDirectSize) {
+      return mDirect[codepoint];
+    }
+    Size slot = this->Probe(codepoint);
+    return slot == mSlots.size() ? sEmpty : mSlots[slot].index;
+  }
+  void Rehash(Size const &capacity);
+
+public:
+  /*
+   * @brief: Glyph records keyed by codepoint.
+   * @detail: Records are stored densely. Codepoints below 512 index a
+   * direct table, the rest an open addressing hash with linear probing,
+   * so Latin text never hashes. Record pointers stay valid until the next
+   * Insert or Erase.
+   */
+  GlyphTable() {}
+  ~GlyphTable() override {}
+
+  /*
+   * @brief: Getter for number of records.
+   * @return: number of records
+   */
+  Size GetSize() const { return mGlyphs.size(); }
+  /*
+   * @brief: Getter for record at dense index.
+   * @param: index: index below GetSize
+   * @return: record
+   */
+  CharacterData const &GetGlyph(Size const &index) const {
+    return mGlyphs[index];
+  }
+  /*
+   * @brief: Getter for key of record at dense index.
+   * @param: index: index below GetSize
+   * @return: codepoint the record is stored under
+   */
+  Uint const &GetCodepoint(Size const &index) const {
+    return mCodepoints[index];
+  }
+  /*
+   * @brief: Getter for last use of record at dense index.
+   * @param: index: index below GetSize
+   * @return: use period passed to Insert or Touch
+   */
+  Uint const &GetLastUse(Size const &index) const { return mUses[index]; }
+
+  /*
+   * @brief: Finds record.
+   * @param: codepoint: codepoint to find
+   * @return: record, or nullptr if missing
+   */
+  CharacterData const *Find(Uint const &codepoint) const {
+    Uint index = this->Locate(codepoint);
+    return index == sEmpty ? nullptr : &mGlyphs[index];
+  }
+  /*
+   * @brief: Marks record as used.
+   * @param: codepoint: codepoint to mark
+   * @param: use: current use period
+   * @return: false if record is missing
+   */
+  Bool Touch(Uint const &codepoint, Uint const &use) {
+    Uint index = this->Locate(codepoint);
+    if (index == sEmpty) {
+      return false;
+    }
+    mUses[index] = use;
+    return true;
+  }
+  /*
+   * @brief: Inserts record.
+   * @param: codepoint: codepoint to store record under
+   * @param: glyph: record
+   * @param: use: current use period
+   * @return: false if codepoint already has a record
+   */
+  Bool Insert(Uint const &codepoint, CharacterData const &glyph,
+              Uint const &use = 0u);
+  /*
+   * @brief: Removes record.
+   * @param: codepoint: codepoint to remove
+   * @return: false if record is missing
+   * @detail: The last record moves into the freed index.
+   */
+  Bool Erase(Uint const &codepoint);
+  /*
+   * @brief: Removes every record.
+   */
+  void Clear();
+};
+
+class SkylinePacker final : public TerreateObjectBase {
+private:
+  struct Segment {
+    Uint x;
+    Uint y;
+    Uint width;
+  };
+
+private:
+  Uint mWidth = 0u;
+  Uint mHeight = 0u;
+  Vec<Segment> mSkyline = Vec<Segment>();
+  Size mUsedArea = 0u;
+
+private:
+  Bool Fit(Size const &index, Uint const &width, Uint const &height,
+           Uint &y) const;
+
+public:
+  /*
+   * @brief: Rectangle packer that tracks the top edge of packed rectangles.
+   */
+  SkylinePacker() {}
+  /*
+   * @brief: Rectangle packer that tracks the top edge of packed rectangles.
+   * @param: width: width of packing area
+   * @param: height: height of packing area
+   */
+  SkylinePacker(Uint const &width, Uint const &height);
+  ~SkylinePacker() override {}
+
+  /*
+   * @brief: Getter for packing area width.
+   * @return: packing area width
+   */
+  Uint const &GetWidth() const { return mWidth; }
+  /*
+   * @brief: Getter for packing area height.
+   * @return: packing area height
+   */
+  Uint const &GetHeight() const { return mHeight; }
+  /*
+   * @brief: Getter for ratio of packed area to packing area.
+   * @return: occupancy in [0, 1]
+   */
+  Float GetOccupancy() const;
+
+  /*
+   * @brief: Packs rectangle at lowest position it fits.
+   * @param: width: width of rectangle
+   * @param: height: height of rectangle
+   * @param: position: packed bottom left corner
+   * @return: false if rectangle does not fit
+   * @detail: Ties are broken by the narrowest skyline segment, which keeps
+   * wide gaps free for wide rectangles.
+   */
+  Bool Pack(Uint const &width, Uint const &height, Pair<Uint> &position);
+  /*
+   * @brief: Removes every packed rectangle.
+   */
+  void Clear();
+};
+
+class FontFace final : public TerreateObjectBase {
+private:
+  Str mPath = "";
+  Shared<MappedFile> mFile = nullptr;
   Shared<FT_Library> mLibrary = nullptr;
-  Shared<FT_Face> mFace = nullptr;
+  FT_Face mFace = nullptr;
+  Map<Uint, FT_Size> mSizes = Map<Uint, FT_Size>();
+  Ulong mHash = 0u;
+
+public:
+  /*
+   * @brief: Parsed font file.
+   * @param: library: FreeType library to open face with
+   * @param: path: path to font file
+   * @detail: The file is memory mapped and parsed in place. Prefer
+   * FontFace::Get, which opens each file once per process.
+   */
+  FontFace(Shared<FT_Library> const &library, Str const &path);
+  ~FontFace() override;
+  FontFace(FontFace const &) = delete;
+  FontFace &operator=(FontFace const &) = delete;
+
+  /*
+   * @brief: Getter for font file path.
+   * @return: path to font file
+   */
+  Str const &GetPath() const { return mPath; }
+  /*
+   * @brief: Getter for mapped font file.
+   * @return: mapping, alive as long as it is referenced
+   * @detail: Background rasterizers open their own faces on it.
+   */
+  Shared<MappedFile> const &GetFile() const { return mFile; }
+  /*
+   * @brief: Getter for FreeType library the face belongs to.
+   * @return: FreeType library
+   */
+  FT_Library GetLibrary() const { return *mLibrary; }
+  /*
+   * @brief: Getter for FreeType face.
+   * @return: FreeType face
+   */
+  FT_Face GetFace() const { return mFace; }
+  /*
+   * @brief: Getter for hash of font file contents.
+   * @return: FNV-1a hash, computed on first call
+   */
+  Ulong GetHash();
+
+  /*
+   * @brief: Activates pixel size.
+   * @param: pixels: pixel size
+   * @return: FreeType face scaled to pixel size
+   * @detail: Each pixel size gets one FT_Size on first use, shared by every
+   * font of that size. Activate again before FreeType calls that scale,
+   * because another font may have switched the size in between.
+   */
+  FT_Face Activate(Uint const &pixels);
+
+  operator Bool() const override { return mFace != nullptr; }
+
+public:
+  /*
+   * @brief: Getter for shared face of font file.
+   * @param: path: path to font file
+   * @return: face, opened on first request
+   * @detail: Faces share one process-wide FreeType library and are kept
+   * while any font references them, so a file loaded at several sizes is
+   * read and parsed once. Faces are not thread safe, so use fonts sharing
+   * a face from one thread.
+   */
+  static Shared<FontFace> Get(Str const &path);
+  /*
+   * @brief: Getter for number of faces alive.
+   * @return: number of faces
+   */
+  static Size GetLoadedCount();
+};
+
+class Font : public TerreateObjectBase {
+private:
+  Shared<FontFace> mFace = nullptr;
+  Vec<Shared<FontFace>> mFallbacks = Vec<Shared<FontFace>>();
+  Str mPath = "";
+  Vec<Str> mFallbackPaths = Vec<Str>();
   Uint mSize;
+  Uint mExpectedGlyphs = 256u;
+  FontRenderMode mRenderMode = FontRenderMode::BITMAP;
+  Uint mSpread = 8u;
   Texture mTexture;
-  Uint mXOffset = 0u;
-  Uint mYOffset = 0u;
-  Uint mZOffset = 0u;
-  Map<wchar_t, CharacterData> mCharacters;
+  Vec<SkylinePacker> mPackers;
+  GlyphTable mGlyphs;
+  Uint mFrame = 0u;
+  Uint mPins = 0u;
+  Uint mPinnedFrame = 0u;
+  Uint mMaxLayers = 0u;
+  Long mAscender = 0;
+  Long mDescender = 0;
+  Long mLineHeight = 0;
+  Bool mHasKerning = false;
+  mutable Map<Ulong, Long> mKerning = Map<Ulong, Long>();
+  Executor *mExecutor = nullptr;
+  Shared<GlyphJobs> mJobs = nullptr;
+  Set<Uint> mPending = Set<Uint>();
+  Uint mGeneration = 0u;
+  Str mCachePath = "";
+  Ulong mFontHash = 0u;
+  Size mCacheSize = 0u;
+  Bool mCacheAppend = false;
+  Bool mCacheSealed = false;
+  Vec<GlyphBitmap> mUnsaved = Vec<GlyphBitmap>();
 
 private:
   void InitializeTexture();
+  void ResetAtlas();
+  void ResetJobs();
+  void ActivateFaces() const;
+  FT_Face SelectFace(Uint const &codepoint) const;
+  Bool ReplayCache();
   void LoadDummyCharacter();
+  Bool LoadSpaceCharacter(wchar_t const &character);
+  Uint EvictLayer();
+  Uint PackGlyph(Uint const &width, Uint const &height, Pair<Uint> &position);
+  void InsertGlyphs(Vec<GlyphBitmap> const &bitmaps);
 
 public:
   /*
    * @brief: Default constructor for RawFont.
    */
-  Font();
+  Font() {}
   /*
    * @brief: Constructor for RawFont.
    * @param: path: path to font file
    * @param: size: size of font
+   * @param: glyphs: expected number of glyphs, used to size the atlas
+   * @param: mode: glyph rasterization mode
    */
-  Font(Str const &path, Uint const &size);
-  ~Font() override;
+  Font(Str const &path, Uint const &size, Uint const &glyphs = 256u,
+       FontRenderMode const &mode = FontRenderMode::BITMAP);
+  ~Font() override {}
 
   /*
    * @brief: Getter for font size.
    * @return: font size
    */
   Uint GetFontSize() const { return mSize; }
+  /*
+   * @brief: Getter for distance from baseline to top of line.
+   * @return: ascender in 26.6 fixed point
+   */
+  Long const &GetAscender() const { return mAscender; }
+  /*
+   * @brief: Getter for distance from baseline to bottom of line.
+   * @return: descender in 26.6 fixed point, usually negative
+   */
+  Long const &GetDescender() const { return mDescender; }
+  /*
+   * @brief: Getter for distance between consecutive baselines.
+   * @return: line height in 26.6 fixed point
+   */
+  Long const &GetLineHeight() const { return mLineHeight; }
+  /*
+   * @brief: Getter for glyph atlas texture.
+   * @return: glyph atlas texture
+   */
+  Texture const &GetTexture() const { return mTexture; }
+  /*
+   * @brief: Getter for glyph rasterization mode.
+   * @return: glyph rasterization mode
+   */
+  FontRenderMode const &GetRenderMode() const { return mRenderMode; }
+  /*
+   * @brief: Getter for distance field spread.
+   * @return: distance in pixels mapped to the full [0, 255] range
+   */
+  Uint const &GetSpread() const { return mSpread; }
+  /*
+   * @brief: Getter for atlas generation.
+   * @return: counter increased every time glyphs are added
+   * @detail: Compare against a stored value to know when text laid out
+   * with placeholders should be rebuilt.
+   */
+  Uint const &GetGeneration() const { return mGeneration; }
+  /*
+   * @brief: Getter for number of glyphs being rasterized in background.
+   * @return: number of pending glyphs
+   */
+  Uint GetPendingCount() const { return mPending.size(); }
+  /*
+   * @brief: Getter for atlas layer limit.
+   * @return: maximum number of layers (0 uses the device limit)
+   */
+  Uint const &GetMaxLayers() const { return mMaxLayers; }
+  /*
+   * @brief: Getter for fallback font files.
+   * @return: paths in the order faces are searched after the primary face
+   */
+  Vec<Str> const &GetFallbackPaths() const { return mFallbackPaths; }
+
+  /*
+   * @brief: Setter for distance field spread.
+   * @param: spread: distance in pixels, between 2 and 32
+   * @detail: Applies to glyphs loaded afterwards. Larger spreads allow
+   * outlines and glows at the cost of atlas space.
+   */
+  void SetSpread(Uint const &spread);
+  /*
+   * @brief: Setter for executor used to rasterize missing glyphs.
+   * @param: executor: executor to rasterize on (nullptr loads glyphs
+   * synchronously)
+   * @detail: With an executor, missing glyphs render as placeholders until
+   * Update picks up their bitmaps. Every worker uses its own FT_Face,
+   * because FreeType faces are not thread safe. The executor must outlive
+   * the font or be reset before it is destroyed.
+   */
+  void SetExecutor(Executor *executor) { mExecutor = executor; }
+  /*
+   * @brief: Setter for atlas layer limit.
+   * @param: layers: maximum number of layers (0 uses the device limit)
+   * @detail: Once the limit is reached, the least recently used layer is
+   * cleared and reused, which bounds atlas memory however many distinct
+   * glyphs are shown.
+   */
+  void SetMaxLayers(Uint const &layers) { mMaxLayers = layers; }
   /*
    * @brief: Getter for character.
    * @param: character: character to get
@@ -64,6 +455,25 @@ public:
    * @return: character
    */
   CharacterData const &AcquireCharacter(wchar_t const &character) const;
+  /*
+   * @brief: Acquirer for kerning between two characters.
+   * @param: left: left character
+   * @param: right: right character
+   * @return: horizontal kerning in 26.6 fixed point
+   * @detail: Pairs are looked up in FreeType once and cached.
+   */
+  Long AcquireKerning(wchar_t const &left, wchar_t const &right) const;
+  /*
+   * @brief: Lays out text on one line.
+   * @param: text: text to lay out
+   * @param: positions: buffer to write one position per character into
+   * @return: pen advance of whole text in 26.6 fixed point
+   * @detail: Pen positions keep 26.6 precision and include kerning. The
+   * buffer is cleared but keeps its capacity, so reusing it allocates
+   * nothing in steady state. Positions point into the glyph table and
+   * stay valid until the atlas generation changes.
+   */
+  Long Layout(WStr const &text, Vec<GlyphPosition> &positions) const;
   /*
    * @brief: Acquirer for text size in pixels.
    * @param: text: text to acquire size of
@@ -81,11 +491,33 @@ public:
    * @brief: Loads font data.
    * @param: path: path to font file
    * @param: size: size of font
+   * @param: glyphs: expected number of glyphs, used to size the atlas
+   * @param: mode: glyph rasterization mode
+   * @detail: SDF glyphs are rasterized once as signed distance fields. One
+   * atlas then renders at any scale with a distance field shader. The file
+   * is opened through FontFace::Get, so fonts of one file share its face.
+   */
+  void LoadFont(Str const &path, Uint const &size, Uint const &glyphs = 256u,
+                FontRenderMode const &mode = FontRenderMode::BITMAP);
+  /*
+   * @brief: Appends fallback face.
+   * @param: path: path to font file
+   * @detail: Each codepoint is rasterized from the first face that maps it,
+   * primary face first, and tofu comes from the primary face. Every face
+   * packs into the same atlas, so text mixing Latin, CJK and symbols from
+   * different files still draws in one call. Line metrics stay those of
+   * the primary face and kerning applies within one face. The atlas is
+   * reset, so add fallbacks before loading text. LoadFont clears them.
    */
-  void LoadFont(Str const &path, Uint const &size);
+  void AddFallback(Str const &path);
   /*
    * @brief: Loads character data.
    * @param: character: character to load
+   * @detail: Glyphs are packed into a single channel atlas with 1 px gaps.
+   * When every layer is full a new layer is appended. At the layer limit
+   * the least recently used layer is evicted and its glyphs are reloaded
+   * on their next use. Throws FontError if every layer was used since the
+   * last Update.
    */
   void LoadCharacter(wchar_t const &character);
   /*
@@ -93,6 +525,63 @@ public:
    * @param: text: text to load
    */
   void LoadText(WStr const &text);
+  /*
+   * @brief: Loads UTF-8 text into OpenGL texture.
+   * @param: text: UTF-8 text to load
+   * @detail: Codepoints go straight to glyph lookup, without decoding into
+   * a wide string first.
+   */
+  void LoadText(Str const &text);
+  /*
+   * @brief: Rasterizes every glyph of charset and uploads them in one batch.
+   * @param: charset: characters to load
+   * @param: executor: executor to rasterize on (nullptr runs inline)
+   * @detail: Blocks until every glyph is in the atlas. Use it at load time
+   * with large sets such as JIS level 1 so typing never hitches.
+   */
+  void Prewarm(WStr const &charset, Executor *executor = nullptr);
+  /*
+   * @brief: Rasterizes every glyph of strings and uploads them in one batch.
+   * @param: strings: strings to load characters of
+   * @param: executor: executor to rasterize on (nullptr runs inline)
+   */
+  void Prewarm(Vec<WStr> const &strings, Executor *executor = nullptr);
+  /*
+   * @brief: Attaches on-disk atlas cache.
+   * @param: path: path to cache file
+   * @return: true if cached glyphs were loaded
+   * @detail: The atlas is reset first. A cache built from the same font
+   * file contents, pixel size, render mode and atlas size is memory mapped
+   * and uploaded without touching FreeType. Otherwise it is rebuilt from
+   * scratch on the next SaveCache.
+   */
+  Bool LoadCache(Str const &path);
+  /*
+   * @brief: Persists glyphs added since the cache was attached or saved.
+   * @detail: New glyphs are appended to a valid cache, so saving after
+   * every session only writes the delta. After an eviction the atlas can
+   * no longer be replayed from the cache, so the file is left as it was.
+   */
+  void SaveCache();
+  /*
+   * @brief: Uploads glyphs finished by background rasterization.
+   * @return: true if atlas changed
+   * @detail: Call on the render thread. Text calls this before drawing and
+   * TextBatch after flushing. Every call starts a new use period, and
+   * layers holding glyphs loaded since the last call are never evicted.
+   */
+  Bool Update();
+  /*
+   * @brief: Keeps glyphs used from the current use period on resident.
+   * @detail: Until every pin is released, layers holding glyphs used since
+   * the oldest pin are never evicted, even across Update. TextBatch pins
+   * its fonts from the first Submit of a frame to Flush or Clear.
+   */
+  void Pin();
+  /*
+   * @brief: Releases one pin taken by Pin.
+   */
+  void Unpin();
 
   /*
    * @brief: Uses font texture.
@@ -0,0 +1,211 @@
+#ifndef __TERREATE_GRAPHICS_IMAGEOPS_HPP__
+#define __TERREATE_GRAPHICS_IMAGEOPS_HPP__
+
+#include "defines.hpp"
+#include "texture.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+// Use to select downsampling filter for mip chain generation.
+enum class DownsampleFilter { BOX, KAISER };
+
+// Use to select resampling filter. BILINEAR is a triangle filter that is not
+// widened on downscale, which matches a single bilinear fetch per texel.
+enum class ResampleFilter { BILINEAR, BOX, TRIANGLE, MITCHELL, LANCZOS3 };
+
+struct ResampleWeights {
+  Uint taps = 0u;
+  Vec<Int> firsts;
+  Vec<Float> weights;
+};
+
+namespace ImageOps {
+/*
+ * @brief: Expands 1, 2 or 3 channel image data to RGBA.
+ * @param: src: source image data
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ * @return: RGBA image data
+ * @detail: Gray is replicated into RGB. Missing alpha is set to 255.
+ */
+TextureData ExpandToRGBA(TextureData const &src, Executor *executor = nullptr);
+/*
+ * @brief: Multiplies color channels by alpha channel in place.
+ * @param: data: RGBA or gray-alpha image data
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ */
+void PremultiplyAlpha(TextureData &data, Executor *executor = nullptr);
+/*
+ * @brief: Flips image rows in place.
+ * @param: data: image data
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ */
+void FlipVertical(TextureData &data, Executor *executor = nullptr);
+/*
+ * @brief: Converts sRGB encoded color channels to linear in place.
+ * @param: data: image data
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ * @detail: Alpha channel is left untouched.
+ */
+void SRGBToLinear(TextureData &data, Executor *executor = nullptr);
+/*
+ * @brief: Converts linear color channels to sRGB encoding in place.
+ * @param: data: image data
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ * @detail: Alpha channel is left untouched.
+ */
+void LinearToSRGB(TextureData &data, Executor *executor = nullptr);
+/*
+ * @brief: Halves image size in each dimension.
+ * @param: src: source image data
+ * @param: filter: downsampling filter
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ * @return: downsampled image data
+ */
+TextureData Downsample(TextureData const &src,
+                       DownsampleFilter const &filter = DownsampleFilter::BOX,
+                       Executor *executor = nullptr);
+/*
+ * @brief: Generates full mip chain of image.
+ * @param: src: base level image data
+ * @param: filter: downsampling filter
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ * @return: mip levels from base level down to 1x1
+ */
+Vec<TextureData> GenerateMipChain(TextureData const &src,
+                                  DownsampleFilter const &filter =
+                                      DownsampleFilter::BOX,
+                                  Executor *executor = nullptr);
+/*
+ * @brief: Computes 1D filter weights for resampling along one axis.
+ * @param: srcSize: number of source texels
+ * @param: dstSize: number of destination texels
+ * @param: filter: resampling filter
+ * @param: gain: sum of every destination texel's weights
+ * @return: normalized weights, scaled by gain
+ * @detail: Destination texel i reads source texels firsts[i] to
+ * firsts[i] + taps - 1, clamped to edge, with weights[i * taps + k].
+ * ImageConverter uploads the same weights, so both paths sum identical
+ * values in identical order. A gain of 1/255 reads bytes as normalized
+ * values without a division per texel.
+ */
+ResampleWeights ComputeResampleWeights(Uint const &srcSize,
+                                       Uint const &dstSize,
+                                       ResampleFilter const &filter,
+                                       Double const &gain = 1.0);
+/*
+ * @brief: Resizes image with separable filter.
+ * @param: src: source image data
+ * @param: width: destination width
+ * @param: height: destination height
+ * @param: filter: resampling filter
+ * @param: executor: executor to run rows on (nullptr runs inline)
+ * @return: resized image data
+ * @detail: Result is bit identical to ImageConverter with the same filter
+ * writing to RGBA8 storage.
+ */
+TextureData Resample(TextureData const &src, Uint const &width,
+                     Uint const &height, ResampleFilter const &filter,
+                     Executor *executor = nullptr);
+/*
+ * @brief: Converts 32 bit floats to 16 bit half floats.
+ * @param: src: source floats
+ * @param: dst: destination halfs
+ * @param: count: number of values
+ * @param: executor: executor to run chunks on (nullptr runs inline)
+ */
+void FloatToHalf(Float const *src, Ushort *dst, Size const &count,
+                 Executor *executor = nullptr);
+/*
+ * @brief: Converts 16 bit half floats to 32 bit floats.
+ * @param: src: source halfs
+ * @param: dst: destination floats
+ * @param: count: number of values
+ * @param: executor: executor to run chunks on (nullptr runs inline)
+ */
+void HalfToFloat(Ushort const *src, Float *dst, Size const &count,
+                 Executor *executor = nullptr);
+} // namespace ImageOps
+
+class ImagePipeline final : public TerreateObjectBase {
+private:
+  Vec<Function<void(TextureData &, Executor *)>> mOperations;
+
+public:
+  /*
+   * @brief: Composable chain of CPU image operations. Every operation runs on
+   * rows in parallel when an executor is given.
+   */
+  ImagePipeline() {}
+  ~ImagePipeline() override {}
+
+  /*
+   * @brief: Getter for number of operations.
+   * @return: number of operations
+   */
+  Uint GetSize() const { return mOperations.size(); }
+
+  /*
+   * @brief: Appends RGBA expansion.
+   * @return: this pipeline
+   */
+  ImagePipeline &ExpandToRGBA();
+  /*
+   * @brief: Appends alpha premultiplication.
+   * @return: this pipeline
+   */
+  ImagePipeline &PremultiplyAlpha();
+  /*
+   * @brief: Appends vertical flip.
+   * @return: this pipeline
+   */
+  ImagePipeline &FlipVertical();
+  /*
+   * @brief: Appends sRGB to linear conversion.
+   * @return: this pipeline
+   */
+  ImagePipeline &SRGBToLinear();
+  /*
+   * @brief: Appends linear to sRGB conversion.
+   * @return: this pipeline
+   */
+  ImagePipeline &LinearToSRGB();
+  /*
+   * @brief: Appends 2x downsampling.
+   * @param: filter: downsampling filter
+   * @return: this pipeline
+   */
+  ImagePipeline &Downsample(DownsampleFilter const &filter);
+  /*
+   * @brief: Appends resize.
+   * @param: width: destination width
+   * @param: height: destination height
+   * @param: filter: resampling filter
+   * @return: this pipeline
+   */
+  ImagePipeline &Resample(Uint const &width, Uint const &height,
+                          ResampleFilter const &filter);
+  /*
+   * @brief: Appends user defined operation.
+   * @param: operation: operation to append
+   * @return: this pipeline
+   */
+  ImagePipeline &Then(Function<void(TextureData &, Executor *)> const &op);
+
+  /*
+   * @brief: Applies all operations to image data in place.
+   * @param: data: image data
+   * @param: executor: executor to run rows on (nullptr runs inline)
+   */
+  void Apply(TextureData &data, Executor *executor = nullptr) const;
+  /*
+   * @brief: Applies all operations to copy of image data.
+   * @param: src: source image data
+   * @param: executor: executor to run rows on (nullptr runs inline)
+   * @return: processed image data
+   */
+  TextureData Run(TextureData const &src, Executor *executor = nullptr) const;
+};
+} // namespace TerreateGraphics::Core
+
+#endif // __TERREATE_GRAPHICS_IMAGEOPS_HPP__
@@ -0,0 +1,198 @@
+#ifndef __TERREATE_GRAPHICS_LAYOUT_HPP__
+#define __TERREATE_GRAPHICS_LAYOUT_HPP__
+
+#include "defines.hpp"
+#include "font.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+using namespace TerreateCore::Math;
+
+struct TextRun {
+  WStr text = L"";
+  vec3 color = vec3(1.0f, 1.0f, 1.0f);
+  Float size = 0.0f; // pixel size, 0 uses font size
+};
+
+struct TextLayoutSettings {
+  Float maxWidth = 0.0f; // 0 disables wrapping
+  TextAlignment alignment = TextAlignment::LEFT;
+  Float lineSpacing = 1.0f; // multiple of face line height
+};
+
+struct LayoutGlyph {
+  Uint codepoint = 0u;
+  Float x = 0.0f; // pen position relative to top left of block
+  Float y = 0.0f; // baseline relative to top left of block
+  Float scale = 1.0f;
+  vec3 color = vec3(1.0f, 1.0f, 1.0f);
+};
+
+struct LayoutLine {
+  Uint first = 0u; // first glyph of line
+  Uint count = 0u;
+  Float width = 0.0f;
+  Float baseline = 0.0f;
+};
+
+class TextLayout final : public TerreateObjectBase {
+private:
+  Font *mFont = nullptr;
+  Vec<LayoutGlyph> mGlyphs = Vec<LayoutGlyph>();
+  Vec<LayoutLine> mLines = Vec<LayoutLine>();
+  Pair<Float> mSize = {0.0f, 0.0f};
+  Bool mProvisional = false;
+  Uint mGeneration = 0u;
+
+public:
+  /*
+   * @brief: Multi-line layout of styled text runs.
+   */
+  TextLayout() {}
+  /*
+   * @brief: Multi-line layout of styled text runs.
+   * @param: font: font to lay out with
+   * @param: runs: text runs in reading order
+   * @param: settings: wrapping, alignment and spacing
+   */
+  TextLayout(Font *font, Vec<TextRun> const &runs,
+             TextLayoutSettings const &settings = TextLayoutSettings()) {
+    this->Build(font, runs, settings);
+  }
+  ~TextLayout() override {}
+
+  /*
+   * @brief: Getter for font the layout was built with.
+   * @return: font
+   */
+  Font *GetFont() const { return mFont; }
+  /*
+   * @brief: Getter for visible glyphs.
+   * @return: glyphs in reading order, without spaces and line breaks
+   */
+  Vec<LayoutGlyph> const &GetGlyphs() const { return mGlyphs; }
+  /*
+   * @brief: Getter for lines.
+   * @return: lines from top to bottom
+   */
+  Vec<LayoutLine> const &GetLines() const { return mLines; }
+  /*
+   * @brief: Getter for block size in pixels.
+   * @return: {width, height}
+   */
+  Pair<Float> const &GetSize() const { return mSize; }
+  /*
+   * @brief: Getter for whether placeholder glyphs were measured.
+   * @return: true if glyphs were still rasterizing in background
+   */
+  Bool const &IsProvisional() const { return mProvisional; }
+  /*
+   * @brief: Checks whether layout should be rebuilt.
+   * @return: true if placeholders were measured and glyphs have landed since
+   */
+  Bool IsStale() const {
+    return mProvisional && mFont->GetGeneration() != mGeneration;
+  }
+
+  /*
+   * @brief: Lays out text runs.
+   * @param: font: font to lay out with
+   * @param: runs: text runs in reading order
+   * @param: settings: wrapping, alignment and spacing
+   * @detail: Lines break at newlines and, when a maximum width is set, at
+   * the last break opportunity that fits: after spaces and hyphens, and
+   * between CJK characters unless closing punctuation or small kana
+   * follow or opening punctuation precedes. Words wider than a line break
+   * between characters. Trailing spaces hang past the line width. Missing
+   * glyphs are loaded through the font.
+   */
+  void Build(Font *font, Vec<TextRun> const &runs,
+             TextLayoutSettings const &settings = TextLayoutSettings());
+};
+
+class TextLayoutCache final : public TerreateObjectBase {
+private:
+  struct Entry {
+    Font *font = nullptr;
+    Vec<TextRun> runs = Vec<TextRun>();
+    TextLayoutSettings settings = TextLayoutSettings();
+    Uint lastUse = 0u;
+    TextLayout layout = TextLayout();
+  };
+
+private:
+  Map<Ulong, Entry> mEntries = Map<Ulong, Entry>();
+  Uint mCapacity = 256u;
+  Uint mClock = 0u;
+
+private:
+  static Ulong Hash(Font const *font, Vec<TextRun> const &runs,
+                    TextLayoutSettings const &settings);
+  void Trim();
+
+public:
+  /*
+   * @brief: Keeps layouts of recently used paragraphs, so text that does
+   * not change is never laid out again.
+   */
+  TextLayoutCache() {}
+  /*
+   * @brief: Keeps layouts of recently used paragraphs, so text that does
+   * not change is never laid out again.
+   * @param: capacity: number of layouts to keep
+   */
+  TextLayoutCache(Uint const &capacity) : mCapacity(capacity) {}
+  ~TextLayoutCache() override {}
+
+  /*
+   * @brief: Getter for number of cached layouts.
+   * @return: number of layouts
+   */
+  Uint GetSize() const { return mEntries.size(); }
+  /*
+   * @brief: Getter for number of layouts kept.
+   * @return: capacity
+   */
+  Uint const &GetCapacity() const { return mCapacity; }
+
+  /*
+   * @brief: Setter for number of layouts kept.
+   * @param: capacity: number of layouts to keep
+   */
+  void SetCapacity(Uint const &capacity) { mCapacity = capacity; }
+
+  /*
+   * @brief: Acquires layout of text runs.
+   * @param: font: font to lay out with
+   * @param: runs: text runs in reading order
+   * @param: settings: wrapping, alignment and spacing
+   * @return: cached layout
+   * @detail: Layouts are keyed by a hash of font, runs and settings and
+   * verified against the stored key. Provisional layouts are rebuilt once
+   * their glyphs land. A full cache drops its least recently used half
+   * before inserting, so keep the capacity above twice the number of
+   * layouts held at once.
+   */
+  TextLayout const &
+  Acquire(Font *font, Vec<TextRun> const &runs,
+          TextLayoutSettings const &settings = TextLayoutSettings());
+  /*
+   * @brief: Acquires layout of text.
+   * @param: font: font to lay out with
+   * @param: text: text to lay out
+   * @param: settings: wrapping, alignment and spacing
+   * @return: cached layout
+   */
+  TextLayout const &
+  Acquire(Font *font, WStr const &text,
+          TextLayoutSettings const &settings = TextLayoutSettings()) {
+    return this->Acquire(font, Vec<TextRun>{{text}}, settings);
+  }
+  /*
+   * @brief: Removes every cached layout.
+   */
+  void Clear() { mEntries.clear(); }
+};
+} // namespace TerreateGraphics::Core
+
+#endif // __TERREATE_GRAPHICS_LAYOUT_HPP__
@@ -0,0 +1,62 @@
+#ifndef __TERREATE_GRAPHICS_PROGRAMCACHE_HPP__
+#define __TERREATE_GRAPHICS_PROGRAMCACHE_HPP__
+
+#include "defines.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+namespace ProgramCache {
+/*
+ * @brief: Getter for directory program binaries are stored in.
+ * @return: directory, empty if the cache is disabled
+ */
+Str const &GetDirectory();
+/*
+ * @brief: Setter for directory program binaries are stored in.
+ * @param: path: directory, created on first save ("" disables the cache)
+ * @detail: Shader and ComputeKernel load linked programs from here
+ * instead of compiling GLSL, and store the programs they had to compile.
+ */
+void SetDirectory(Str const &path);
+/*
+ * @brief: Checks whether programs are cached.
+ * @return: true if a directory is set and the driver exposes binaries
+ */
+Bool IsEnabled();
+
+/*
+ * @brief: Computes cache key of program.
+ * @param: sources: source of every stage, in a fixed order
+ * @return: key
+ * @detail: The driver vendor, renderer and version are part of the key,
+ * so a driver update never loads binaries built by the old one.
+ */
+Ulong Hash(Vec<Str> const &sources);
+/*
+ * @brief: Loads cached binary into program.
+ * @param: program: OpenGL program without attached shaders
+ * @param: key: cache key
+ * @return: true if program is linked from the binary
+ * @detail: Missing, corrupt and rejected binaries return false, and the
+ * program should then be compiled from source.
+ */
+Bool Load(Uint const &program, Ulong const &key);
+/*
+ * @brief: Requests program binary retrieval.
+ * @param: program: OpenGL program about to be linked
+ * @detail: Call before linking a program that will be saved.
+ */
+void Prepare(Uint const &program);
+/*
+ * @brief: Stores binary of linked program.
+ * @param: program: linked OpenGL program
+ * @param: key: cache key
+ * @detail: Binaries are written to a temporary file and renamed, so an
+ * interrupted save never leaves a torn entry.
+ */
+void Save(Uint const &program, Ulong const &key);
+} // namespace ProgramCache
+} // namespace TerreateGraphics::Core
+
+#endif // __TERREATE_GRAPHICS_PROGRAMCACHE_HPP__
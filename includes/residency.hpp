@@ -0,0 +1,99 @@
+#ifndef __TERREATE_GRAPHICS_RESIDENCY_HPP__
+#define __TERREATE_GRAPHICS_RESIDENCY_HPP__
+
+#include "defines.hpp"
+#include "screen.hpp"
+#include "texture.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+class ResidencyManager final : public TerreateObjectBase {
+private:
+  struct Entry {
+    Function<Size()> footprint;
+    Function<Bool()> evict;
+    Function<void()> restore;
+    Ulong lastUse = 0u;
+  };
+
+private:
+  Size mBudget = 0u;
+  Ulong mUseCount = 0u;
+  Map<TerreateObjectBase const *, Entry> mEntries;
+
+private:
+  void Enforce(TerreateObjectBase const *keep);
+
+public:
+  /*
+   * @brief: Tracks GPU memory of registered textures and evicts least
+   * recently used ones to stay within budget.
+   * @param: budget: GPU memory budget in bytes
+   */
+  ResidencyManager(Size const &budget) : mBudget(budget) {}
+  ~ResidencyManager() override {}
+
+  /*
+   * @brief: Getter for GPU memory budget.
+   * @return: budget in bytes
+   */
+  Size const &GetBudget() const { return mBudget; }
+  /*
+   * @brief: Getter for GPU memory held by registered resources.
+   * @return: size in bytes
+   */
+  Size GetUsage() const;
+
+  /*
+   * @brief: Setter for GPU memory budget.
+   * @param: budget: budget in bytes
+   * @detail: Resources are evicted immediately if usage exceeds budget.
+   */
+  void SetBudget(Size const &budget);
+
+  /*
+   * @brief: Registers texture for eviction.
+   * @param: texture: texture to track
+   * @param: restore: reloads texture data after its storage is restored
+   * @detail: texture should outlive registration. Evicted textures drop one
+   * mip level at a time, then release their storage. Loading data into an
+   * evicted texture throws, so Touch it before loading.
+   */
+  void Register(Texture &texture, Function<void(Texture &)> const &restore);
+  /*
+   * @brief: Registers cube texture for eviction.
+   * @param: texture: cube texture to track
+   * @param: restore: reloads texture data after its storage is restored
+   */
+  void Register(CubeTexture &texture,
+                Function<void(CubeTexture &)> const &restore);
+  /*
+   * @brief: Registers screen attachments.
+   * @param: screen: screen to track
+   * @detail: Render targets count against budget but are never evicted.
+   */
+  void Register(Screen const &screen);
+  /*
+   * @brief: Stops tracking resource.
+   * @param: resource: registered texture, cube texture or screen
+   */
+  void Unregister(TerreateObjectBase const &resource) {
+    mEntries.erase(&resource);
+  }
+
+  /*
+   * @brief: Marks resource as used and restores it if evicted.
+   * @param: resource: registered texture, cube texture or screen
+   * @detail: Call when resource is bound. Other resources may be evicted to
+   * make room.
+   */
+  void Touch(TerreateObjectBase const &resource);
+  /*
+   * @brief: Evicts least recently used resources until usage fits budget.
+   */
+  void Enforce() { this->Enforce(nullptr); }
+};
+} // namespace TerreateGraphics::Core
+
+#endif // __TERREATE_GRAPHICS_RESIDENCY_HPP__
@@ -0,0 +1,110 @@
+#ifndef __TERREATE_GRAPHICS_SAMPLER_HPP__
+#define __TERREATE_GRAPHICS_SAMPLER_HPP__
+
+#include "defines.hpp"
+#include "globj.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+using namespace TerreateGraphics::GL;
+
+struct SamplerDescriptor {
+  FilterType minFilter = FilterType::LINEAR;
+  FilterType magFilter = FilterType::LINEAR;
+  WrappingType wrapS = WrappingType::REPEAT;
+  WrappingType wrapT = WrappingType::REPEAT;
+  WrappingType wrapR = WrappingType::REPEAT;
+  Float anisotropy = 1.0f;
+  Float lodBias = 0.0f;
+  Bool compare = false;
+  DepthFunction compareFunction = DepthFunction::LEQUAL;
+
+  Bool operator==(SamplerDescriptor const &other) const = default;
+};
+
+struct SamplerDescriptorHash {
+  Size operator()(SamplerDescriptor const &descriptor) const;
+};
+
+class Sampler final : public TerreateObjectBase {
+private:
+  static Uint sActiveUnit;
+
+private:
+  GLObject mSampler = GLObject();
+  SamplerDescriptor mDescriptor = SamplerDescriptor();
+
+public:
+  /*
+   * @brief: This function creates empty sampler. Binding it restores texture
+   * parameters of bound texture.
+   */
+  Sampler() {}
+  /*
+   * @brief: This function creates a opengl sampler object.
+   * @param: descriptor: sampler state
+   * @detail: Prefer Sampler::Get, which shares one object per descriptor.
+   */
+  Sampler(SamplerDescriptor const &descriptor);
+  ~Sampler() override;
+
+  /*
+   * @brief: Getter for OpenGL sampler ID.
+   * @return: OpenGL sampler ID
+   */
+  Uint const &GetGLIndex() const { return mSampler; }
+  /*
+   * @brief: Getter for sampler state.
+   * @return: sampler state
+   */
+  SamplerDescriptor const &GetDescriptor() const { return mDescriptor; }
+
+  /*
+   * @brief: Binds sampler to texture unit.
+   * @param: unit: texture unit index
+   */
+  void Bind(Uint const &unit) const { glBindSampler(unit, mSampler); }
+  /*
+   * @brief: Binds sampler to active texture unit.
+   */
+  void Bind() const { this->Bind(sActiveUnit); }
+
+  operator Bool() const override { return (TCu32)mSampler != 0u; }
+
+public:
+  /*
+   * @brief: Getter for shared sampler matching descriptor.
+   * @param: descriptor: sampler state
+   * @return: cached sampler
+   * @detail: Samplers are created on first request and shared afterwards.
+   */
+  static Sampler const &Get(SamplerDescriptor const &descriptor);
+  /*
+   * @brief: Releases every cached sampler.
+   * @detail: Called by Terminate while OpenGL context is still alive.
+   */
+  static void ClearCache();
+  /*
+   * @brief: Unbinds sampler from texture unit.
+   * @param: unit: texture unit index
+   */
+  static void Unbind(Uint const &unit) { glBindSampler(unit, 0); }
+  /*
+   * @brief: Unbinds sampler from active texture unit.
+   */
+  static void Unbind() { Sampler::Unbind(sActiveUnit); }
+  /*
+   * @brief: Getter for active texture unit index.
+   * @return: active texture unit index
+   */
+  static Uint const &GetActiveUnit() { return sActiveUnit; }
+  /*
+   * @brief: Setter for active texture unit index.
+   * @param: unit: active texture unit index
+   * @detail: Only tracks the unit. Use Shader::ActivateTexture to change it.
+   */
+  static void SetActiveUnit(Uint const &unit) { sActiveUnit = unit; }
+};
+} // namespace TerreateGraphics::Core
+
+#endif // __TERREATE_GRAPHICS_SAMPLER_HPP__
@@ -44,6 +44,14 @@ public:
    * @return: texture set
    */
   Texture const &GetTexture() const { return mTexture; }
+  /*
+   * @brief: Getter for GPU memory held by color and depth attachments.
+   * @return: size in bytes
+   */
+  Size GetByteSize() const {
+    // Depth and stencil share one 32 bit renderbuffer texel.
+    return mTexture.GetByteSize() + (Size)mWidth * mHeight * 4;
+  }
 
   /*
    * @brief: Transcript to other screen.
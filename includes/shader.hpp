@@ -3,6 +3,9 @@
 
 #include "defines.hpp"
 #include "globj.hpp"
+#include "sampler.hpp"
+
+#include <cstring>
 
 namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
@@ -28,15 +31,48 @@ struct ShaderOption {
   StencilOperation dpPass = StencilOperation::KEEP;
 };
 
+struct UniformHandle {
+  Int location = -1;
+  Uint offset = 0u;   // byte offset of value in program's shadow
+  Uint capacity = 0u; // shadowed bytes from offset, 0 if not shadowed
+
+  operator Bool() const { return location >= 0; }
+};
+
 class Shader final : public TerreateObjectBase {
+private:
+  struct UniformTable {
+    Map<Str, UniformHandle> handles = Map<Str, UniformHandle>();
+    Vec<Ubyte> shadow = Vec<Ubyte>();
+  };
+
 private:
   Bool mCompiled = false;
   Bool mLinked = false;
+  Bool mBinaryLoaded = false;
+  Ulong mCacheKey = 0u;
   GLObject mShaderID = GLObject();
   Str mVertexShaderSource = "";
   Str mFragmentShaderSource = "";
   Str mGeometryShaderSource = "";
   ShaderOption mOption;
+  Shared<UniformTable> mUniforms = Shared<UniformTable>(new UniformTable());
+
+private:
+  void ReflectUniforms();
+  Bool Shadow(UniformHandle const &uniform, void const *value,
+              Size const &size) const {
+    if (size > uniform.capacity) {
+      return uniform.location >= 0;
+    }
+
+    Ubyte *shadow = mUniforms->shadow.data() + uniform.offset;
+    if (std::memcmp(shadow, value, size) == 0) {
+      return false;
+    }
+    std::memcpy(shadow, value, size);
+    return true;
+  }
 
 public:
   /*
@@ -60,7 +96,22 @@ public:
    * @return: uniform ID
    */
   unsigned GetLocation(Str const &name) const {
-    return glGetUniformLocation(mShaderID, name.c_str());
+    return this->GetUniform(name).location;
+  }
+  /*
+   * @brief: Getter for uniform handle.
+   * @param: name: name of uniform, or of an array element
+   * @return: handle, invalid if program has no such uniform
+   * @detail: Uniforms are enumerated once by Link. Acquire handles after
+   * linking and set through them to skip the name lookup. Handles stay
+   * valid until the program is linked again.
+   */
+  UniformHandle GetUniform(Str const &name) const {
+    auto it = mUniforms->handles.find(name);
+    if (it == mUniforms->handles.end()) {
+      return UniformHandle();
+    }
+    return it->second;
   }
   /*
    * @brief: Getter for uniform block index.
@@ -80,13 +131,37 @@ public:
                                      name.c_str());
   }
 
+  /*
+   * @brief: Setter for shader Bool uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetBool(UniformHandle const &uniform, Bool const &value) const {
+    Int v = value;
+    if (this->Shadow(uniform, &v, sizeof(v))) {
+      glUniform1i(uniform.location, v);
+    }
+  }
   /*
    * @brief: Setter for shader Bool uniform.
    * @param: name: name of uniform
    * @param: value: value of uniform
    */
   void SetBool(Str const &name, Bool const &value) const {
-    glUniform1i(this->GetLocation(name), static_cast<Int>(value));
+    this->SetBool(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader Bool array uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   * @param: count: number of elements in array
+   */
+  void SetBools(UniformHandle const &uniform, Bool const *value,
+                Uint const &count) const {
+    Int const *v = reinterpret_cast<Int const *>(value);
+    if (this->Shadow(uniform, v, count * sizeof(Int))) {
+      glUniform1iv(uniform.location, count, v);
+    }
   }
   /*
    * @brief: Setter for shader Bool array uniform.
@@ -95,8 +170,17 @@ public:
    * @param: count: number of elements in array
    */
   void SetBools(Str const &name, Bool const *value, Uint const &count) const {
-    glUniform1iv(this->GetLocation(name), count,
-                 reinterpret_cast<Int const *>(value));
+    this->SetBools(this->GetUniform(name), value, count);
+  }
+  /*
+   * @brief: Setter for shader Int uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetInt(UniformHandle const &uniform, Int const &value) const {
+    if (this->Shadow(uniform, &value, sizeof(value))) {
+      glUniform1i(uniform.location, value);
+    }
   }
   /*
    * @brief: Setter for shader Int uniform.
@@ -104,7 +188,19 @@ public:
    * @param: value: value of uniform
    */
   void SetInt(Str const &name, Int const &value) const {
-    glUniform1i(this->GetLocation(name), value);
+    this->SetInt(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader Int array uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   * @param: count: number of elements in array
+   */
+  void SetInts(UniformHandle const &uniform, Int const *value,
+               Uint const &count) const {
+    if (this->Shadow(uniform, value, count * sizeof(Int))) {
+      glUniform1iv(uniform.location, count, value);
+    }
   }
   /*
    * @brief: Setter for shader Int array uniform.
@@ -113,7 +209,15 @@ public:
    * @param: count: number of elements in array
    */
   void SetInts(Str const &name, Int const *value, Uint const &count) const {
-    glUniform1iv(this->GetLocation(name), count, value);
+    this->SetInts(this->GetUniform(name), value, count);
+  }
+  /*
+   * @brief: Setter for shader Int array uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetInts(UniformHandle const &uniform, Vec<Int> const &value) const {
+    this->SetInts(uniform, value.data(), value.size());
   }
   /*
    * @brief: Setter for shader Int array uniform.
@@ -121,7 +225,17 @@ public:
    * @param: value: value of uniform
    */
   void SetInts(Str const &name, Vec<Int> value) const {
-    this->SetInts(name, value.data(), value.size());
+    this->SetInts(this->GetUniform(name), value.data(), value.size());
+  }
+  /*
+   * @brief: Setter for shader float uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetFloat(UniformHandle const &uniform, Float const &value) const {
+    if (this->Shadow(uniform, &value, sizeof(value))) {
+      glUniform1f(uniform.location, value);
+    }
   }
   /*
    * @brief: Setter for shader float uniform.
@@ -129,7 +243,19 @@ public:
    * @param: value: value of uniform
    */
   void SetFloat(Str const &name, Float const &value) const {
-    glUniform1f(this->GetLocation(name), value);
+    this->SetFloat(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader float array uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   * @param: count: number of elements in array
+   */
+  void SetFloats(UniformHandle const &uniform, Float const *value,
+                 Uint const &count) const {
+    if (this->Shadow(uniform, value, count * sizeof(Float))) {
+      glUniform1fv(uniform.location, count, value);
+    }
   }
   /*
    * @brief: Setter for shader float array uniform.
@@ -138,7 +264,15 @@ public:
    * @param: count: number of elements in array
    */
   void SetFloats(Str const &name, Float const *value, Uint const &count) const {
-    glUniform1fv(this->GetLocation(name), count, value);
+    this->SetFloats(this->GetUniform(name), value, count);
+  }
+  /*
+   * @brief: Setter for shader float array uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetFloats(UniformHandle const &uniform, Vec<Float> const &value) const {
+    this->SetFloats(uniform, value.data(), value.size());
   }
   /*
    * @brief: Setter for shader float array uniform.
@@ -146,7 +280,17 @@ public:
    * @param: value: value of uniform
    */
   void SetFloats(Str const &name, Vec<Float> value) const {
-    this->SetFloats(name, value.data(), value.size());
+    this->SetFloats(this->GetUniform(name), value.data(), value.size());
+  }
+  /*
+   * @brief: Setter for shader vec2 uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetVec2(UniformHandle const &uniform, vec2 const &value) const {
+    if (this->Shadow(uniform, &value[0], 2 * sizeof(Float))) {
+      glUniform2fv(uniform.location, 1, &value[0]);
+    }
   }
   /*
    * @brief: Setter for shader vec2 uniform.
@@ -154,7 +298,17 @@ public:
    * @param: value: value of uniform
    */
   void SetVec2(Str const &name, vec2 const &value) const {
-    glUniform2fv(this->GetLocation(name), 1, &value[0]);
+    this->SetVec2(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader vec3 uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetVec3(UniformHandle const &uniform, vec3 const &value) const {
+    if (this->Shadow(uniform, &value[0], 3 * sizeof(Float))) {
+      glUniform3fv(uniform.location, 1, &value[0]);
+    }
   }
   /*
    * @brief: Setter for shader vec3 uniform.
@@ -162,7 +316,17 @@ public:
    * @param: value: value of uniform
    */
   void SetVec3(Str const &name, vec3 const &value) const {
-    glUniform3fv(this->GetLocation(name), 1, &value[0]);
+    this->SetVec3(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader vec4 uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetVec4(UniformHandle const &uniform, vec4 const &value) const {
+    if (this->Shadow(uniform, &value[0], 4 * sizeof(Float))) {
+      glUniform4fv(uniform.location, 1, &value[0]);
+    }
   }
   /*
    * @brief: Setter for shader vec4 uniform.
@@ -170,7 +334,17 @@ public:
    * @param: value: value of uniform
    */
   void SetVec4(Str const &name, vec4 const &value) const {
-    glUniform4fv(this->GetLocation(name), 1, &value[0]);
+    this->SetVec4(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader mat2 uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetMat2(UniformHandle const &uniform, mat2 const &value) const {
+    if (this->Shadow(uniform, &value[0][0], 4 * sizeof(Float))) {
+      glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &value[0][0]);
+    }
   }
   /*
    * @brief: Setter for shader mat2 uniform.
@@ -178,7 +352,17 @@ public:
    * @param: value: value of uniform
    */
   void SetMat2(Str const &name, mat2 const &value) const {
-    glUniformMatrix2fv(this->GetLocation(name), 1, GL_FALSE, &value[0][0]);
+    this->SetMat2(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader mat3 uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetMat3(UniformHandle const &uniform, mat3 const &value) const {
+    if (this->Shadow(uniform, &value[0][0], 9 * sizeof(Float))) {
+      glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &value[0][0]);
+    }
   }
   /*
    * @brief: Setter for shader mat3 uniform.
@@ -186,7 +370,17 @@ public:
    * @param: value: value of uniform
    */
   void SetMat3(Str const &name, mat3 const &value) const {
-    glUniformMatrix3fv(this->GetLocation(name), 1, GL_FALSE, &value[0][0]);
+    this->SetMat3(this->GetUniform(name), value);
+  }
+  /*
+   * @brief: Setter for shader mat4 uniform.
+   * @param: uniform: handle of uniform
+   * @param: value: value of uniform
+   */
+  void SetMat4(UniformHandle const &uniform, mat4 const &value) const {
+    if (this->Shadow(uniform, &value[0][0], 16 * sizeof(Float))) {
+      glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &value[0][0]);
+    }
   }
   /*
    * @brief: Setter for shader mat4 uniform.
@@ -194,7 +388,7 @@ public:
    * @param: value: value of uniform
    */
   void SetMat4(Str const &name, mat4 const &value) const {
-    glUniformMatrix4fv(this->GetLocation(name), 1, GL_FALSE, &value[0][0]);
+    this->SetMat4(this->GetUniform(name), value);
   }
   /*
    * @brief: Setter for blending function.
@@ -294,10 +488,16 @@ public:
   void UseStencil(Bool const &value) { mOption.stencil = value; }
   /*
    * @brief: Compile shader.
+   * @detail: With a program cache directory set, a binary of the same
+   * sources is loaded instead and no GLSL is compiled.
    */
   void Compile();
   /*
    * @brief: Link shader.
+   * @detail: Active uniforms are enumerated into a table together with a
+   * shadow of their values, read back from the program. Setters skip
+   * values equal to the shadow, so the program must only be changed
+   * through this object and its copies.
    */
   void Link();
   /*
@@ -327,6 +527,7 @@ public:
    */
   static void ActivateTexture(TextureTargets const &target) {
     glActiveTexture((Uint)target);
+    Sampler::SetActiveUnit((Uint)target - GL_TEXTURE0);
   }
 };
 } // namespace TerreateGraphics::Core
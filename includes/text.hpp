@@ -4,7 +4,11 @@
 #include "buffer.hpp"
 #include "defines.hpp"
 #include "font.hpp"
+#include "layout.hpp"
 #include "shader.hpp"
+#include "unicode.hpp"
+
+#include <cstddef>
 
 namespace TerreateGraphics::Core {
 using namespace TerreateGraphics::Defines;
@@ -14,8 +18,12 @@ private:
   Bool mShaderLoaded = false;
   WStr mLastText = L"";
   WStr mText = L"";
+  Uint mLastGeneration = 0u;
   Vec<Float> mVertices;
   Vec<Uint> mIndices;
+  Vec<GlyphPosition> mPositions;
+  Vec<Uint> mQuadOffsets;
+  Uint mQuadCapacity = 0u;
   Buffer mBuffer;
   Map<Str, AttributeData> mAttributes = {
       {"iPosition", {0, 0, 3, 6 * sizeof(Float), 0}},
@@ -23,20 +31,26 @@ private:
   Map<Str, Uint> mLocations = {{"iPosition", 0}, {"iUV", 1}};
   Font *mFont = nullptr;
   Core::Shader mShader;
+  UniformHandle mTextureUniform;
+  UniformHandle mModelUniform;
+  UniformHandle mTransformUniform;
+  UniformHandle mColorUniform;
   vec3 mColor = vec3(1.0f, 1.0f, 1.0f);
+  Float mSize = 0.0f;
 
 private:
   void LoadText();
+  void AcquireUniforms();
 
 public:
   Text() {}
   /*
    * @brief: Construct text object
-   * @param: text: Text to set
+   * @param: text: UTF-8 text to set
    * @param: font: Font to use
    */
-  Text(Str const &text, Font *font)
-      : mText(WStr(text.begin(), text.end())), mFont(font) {
+  Text(Str const &text, Font *font) : mFont(font) {
+    Unicode::DecodeUTF8(text, mText);
     this->LoadText();
   }
   /*
@@ -49,11 +63,39 @@ public:
   }
   ~Text() override {}
 
+  /*
+   * @brief: Get text
+   * @return: Text
+   */
+  WStr const &GetText() const { return mText; }
+  /*
+   * @brief: Get font of the text
+   * @return: Font
+   */
+  Font *GetFont() const { return mFont; }
+  /*
+   * @brief: Get color of the text
+   * @return: Color
+   */
+  vec3 const &GetColor() const { return mColor; }
+  /*
+   * @brief: Get rendered pixel size of the text
+   * @return: Pixel size (0 renders at font size)
+   */
+  Float const &GetSize() const { return mSize; }
+
   /*
    * @brief: Set color of the text
    * @param: color: Color to set
    */
   void SetColor(vec3 const &color) { mColor = color; }
+  /*
+   * @brief: Set rendered pixel size of the text
+   * @param: size: Pixel size to render at (0 renders at font size)
+   * @note: Glyphs are scaled from the font atlas. Use a font loaded with
+   * FontRenderMode::SDF and a distance field shader to keep edges crisp.
+   */
+  void SetSize(Float const &size) { mSize = size; }
   /*
    * @brief: Set text
    * @param: text: Text to set
@@ -61,18 +103,19 @@ public:
   void SetText(WStr const &text) { this->LoadText(text); }
   /*
    * @brief: Set text
-   * @param: text: Text to set
+   * @param: text: UTF-8 text to set
    */
-  void SetText(Str const &text) {
-    this->LoadText(WStr(text.begin(), text.end()));
-  }
+  void SetText(Str const &text) { this->LoadText(text); }
 
   void LoadFont(Font *font) { mFont = font; }
   /*
    * @brief: Load shader from object
    * @param: shader: Shader object
    */
-  void LoadShader(Shader const &shader) { mShader = shader; }
+  void LoadShader(Shader const &shader) {
+    mShader = shader;
+    this->AcquireUniforms();
+  }
   /*
    * @brief: Load shader from file
    * @param: vertexPath: Path to the vertex shader
@@ -87,11 +130,14 @@ public:
   void LoadText(WStr const &text);
   /*
    * @brief: Load text to the buffer
-   * @param: text: Text to load
+   * @param: text: UTF-8 text to load
    * @note: This function needs to be called after LoadFont and LoadShader
+   * @detail: Text is decoded in place, so updating a label allocates
+   * nothing once its string has grown to size.
    */
   void LoadText(Str const &text) {
-    this->LoadText(WStr(text.begin(), text.end()));
+    Unicode::DecodeUTF8(text, mText);
+    this->LoadText();
   }
 
   /*
@@ -107,6 +153,150 @@ public:
   Text &operator=(Str const &text);
   Text &operator=(WStr const &text);
 };
+
+struct GlyphInstance {
+  Float rect[4] = {0.0f, 0.0f, 0.0f, 0.0f}; // x, y, width, height in pixels
+  Ushort uv[4] = {0u, 0u, 0u, 0u}; // bottom left, top right, normalized
+  Ushort layer = 0u;
+  Ushort padding = 0u;
+  Ubyte color[4] = {255u, 255u, 255u, 255u};
+};
+
+class TextBatch : public TerreateObjectBase {
+private:
+  struct FontBatch {
+    Font *font = nullptr;
+    Bool submitted = false;
+    Vec<GlyphInstance> instances;
+  };
+
+private:
+  Bool mShaderLoaded = false;
+  Vec<FontBatch> mBatches;
+  Vec<GlyphInstance> mInstances;
+  Vec<GlyphPosition> mPositions;
+  WStr mDecoded = L"";
+  Uint mInstanceCapacity = 0u;
+  Buffer mBuffer;
+  Map<Str, AttributeData> mAttributes = {
+      {"iRect",
+       {0, 0, 4, sizeof(GlyphInstance), offsetof(GlyphInstance, rect)}},
+      {"iUV",
+       {0, 1, 4, sizeof(GlyphInstance), offsetof(GlyphInstance, uv),
+        AttributeType::UNSIGNED_SHORT, true}},
+      {"iLayer",
+       {0, 2, 1, sizeof(GlyphInstance), offsetof(GlyphInstance, layer),
+        AttributeType::UNSIGNED_SHORT}},
+      {"iColor",
+       {0, 3, 4, sizeof(GlyphInstance), offsetof(GlyphInstance, color),
+        AttributeType::UNSIGNED_BYTE, true}}};
+  Map<Str, Uint> mLocations = {
+      {"iRect", 0}, {"iUV", 1}, {"iLayer", 2}, {"iColor", 3}};
+  Core::Shader mShader;
+  UniformHandle mTextureUniform;
+  UniformHandle mTransformUniform;
+
+private:
+  FontBatch &AcquireBatch(Font *font);
+  void AcquireUniforms();
+  void Draw(Uint const &count, Float const &windowWidth,
+            Float const &windowHeight);
+
+public:
+  /*
+   * @brief: Collects the strings of a frame and draws them with one draw call
+   * per font atlas.
+   * @detail: Each glyph is one 32 byte GlyphInstance, expanded to a quad by
+   * the vertex shader. Glyphs carry their color, so strings of any color
+   * share a draw. Strings of one font are drawn in submission order, fonts
+   * in order of their first submission.
+   */
+  TextBatch() {}
+  ~TextBatch() override {}
+
+  /*
+   * @brief: Get number of glyph quads submitted this frame
+   * @return: Number of quads
+   */
+  Uint GetQuadCount() const;
+
+  /*
+   * @brief: Load shader from object
+   * @param: shader: Shader object
+   * @detail: The shader receives the GlyphInstance fields iRect, iUV,
+   * iLayer and iColor at locations 0 to 3 once per glyph, and the uTexture
+   * and uTransform uniforms. It draws a 4 vertex triangle strip per glyph.
+   */
+  void LoadShader(Shader const &shader) {
+    mShader = shader;
+    this->AcquireUniforms();
+  }
+  /*
+   * @brief: Load shader from file
+   * @param: vertexPath: Path to the vertex shader
+   * @param: fragmentPath: Path to the fragment shader
+   */
+  void LoadShader(Str const &vertexPath, Str const &fragmentPath);
+
+  /*
+   * @brief: Submit string for this frame
+   * @param: text: Text to draw
+   * @param: font: Font to use
+   * @param: x: X position of the text
+   * @param: y: Y position of the text
+   * @param: color: Color of the text
+   * @param: size: Pixel size to render at (0 renders at font size)
+   */
+  void Submit(WStr const &text, Font *font, Float const &x, Float const &y,
+              vec3 const &color = vec3(1.0f, 1.0f, 1.0f),
+              Float const &size = 0.0f);
+  /*
+   * @brief: Submit string for this frame
+   * @param: text: UTF-8 text to draw
+   * @param: font: Font to use
+   * @param: x: X position of the text
+   * @param: y: Y position of the text
+   * @param: color: Color of the text
+   * @param: size: Pixel size to render at (0 renders at font size)
+   */
+  void Submit(Str const &text, Font *font, Float const &x, Float const &y,
+              vec3 const &color = vec3(1.0f, 1.0f, 1.0f),
+              Float const &size = 0.0f) {
+    Unicode::DecodeUTF8(text, mDecoded);
+    this->Submit(mDecoded, font, x, y, color, size);
+  }
+  /*
+   * @brief: Submit text object for this frame
+   * @param: text: Text object supplying string, font, color and size
+   * @param: x: X position of the text
+   * @param: y: Y position of the text
+   */
+  void Submit(Text const &text, Float const &x, Float const &y) {
+    this->Submit(text.GetText(), text.GetFont(), x, y, text.GetColor(),
+                 text.GetSize());
+  }
+  /*
+   * @brief: Submit laid out paragraph for this frame
+   * @param: layout: Layout supplying font, glyphs, colors and sizes
+   * @param: x: X position of the left edge of the block
+   * @param: y: Y position of the top edge of the block
+   * @detail: Take layouts from a TextLayoutCache to skip layout for
+   * paragraphs that did not change.
+   */
+  void Submit(TextLayout const &layout, Float const &x, Float const &y);
+
+  /*
+   * @brief: Draw all submitted strings and clear the batch
+   * @param: windowWidth: Width of the window
+   * @param: windowHeight: Height of the window
+   */
+  void Flush(Float const &windowWidth, Float const &windowHeight);
+  /*
+   * @brief: Drop all submitted strings without drawing
+   * @detail: Releases the font pins taken by Submit, like Flush.
+   */
+  void Clear();
+};
 } // namespace TerreateGraphics::Core
 
 #endif // __TERREATE_GRAPHICS_TEXT_HPP__
@@ -3,6 +3,7 @@
 
 #include "defines.hpp"
 #include "globj.hpp"
+#include "sampler.hpp"
 
 namespace TerreateGraphics::Compute {
 class ImageConverter;
@@ -19,6 +20,15 @@ struct TextureData {
   Uint channels = 0u;
 };
 
+struct TextureRegion {
+  Uint x = 0u;
+  Uint y = 0u;
+  Uint layer = 0u;
+  Uint width = 0u;
+  Uint height = 0u;
+  Ubyte const *pixels = nullptr;
+};
+
 enum class TextureSize {
   S256 = 256,
   S512 = 512,
@@ -31,13 +41,23 @@ enum class TextureSize {
 };
 
 class Texture final : public TerreateObjectBase {
+private:
+  // Storage bookkeeping, shared by copies like the OpenGL texture ID.
+  struct LayerTable {
+    Map<Str, Uint> textures = Map<Str, Uint>();
+    Vec<Uint> freeLayers = Vec<Uint>();
+    Uint layers = 0u;
+    Uint usedLayers = 0u;
+    Uint evictedLevels = 0u;
+  };
+
 private:
   GLObject mTexture = GLObject();
   Pair<Uint> mSize = {0u, 0u};
-  Uint mLayers = 0u;
-  Pair<FilterType> mFilter = {FilterType::LINEAR, FilterType::LINEAR};
-  Pair<WrappingType> mWrap = {WrappingType::REPEAT, WrappingType::REPEAT};
-  Map<Str, Uint> mTextures = Map<Str, Uint>();
+  Uint mLevels = 1u;
+  TextureChannelType mFormat = TextureChannelType::RGBA32F;
+  Sampler mSampler = Sampler::Get(SamplerDescriptor());
+  Shared<LayerTable> mLayers = Shared<LayerTable>(new LayerTable());
 
 private:
   friend class Screen;
@@ -51,13 +71,18 @@ private:
    */
   Texture(GLObject const &texture, Uint const &width, Uint const &height,
           Uint const &layers)
-      : mTexture(texture), mSize(width, height), mLayers(layers) {}
+      : mTexture(texture), mSize(width, height) {
+    mLayers->layers = layers;
+  }
 
+  void MarkLayer(Uint const &layer);
+  void Reallocate(Uint const &layers, Uint const &evicted);
   void AddBinding(Str const &name) {
-    mTextures.insert({name, mTextures.size()});
+    this->AddBinding(name, mLayers->usedLayers);
   }
   void AddBinding(Str const &name, Uint const &index) {
-    mTextures.insert({name, index});
+    this->MarkLayer(index);
+    mLayers->textures.insert({name, index});
   }
 
 public:
@@ -70,16 +95,19 @@ public:
    * @param: width: width of texture
    * @param: height: height of texture
    * @param: layers: number of layers in texture
-   * @param: type: type of texture channel
+   * @param: format: internal format of texture
    */
-  Texture(Uint const &width, Uint const &height, Uint const &layers = 1);
+  Texture(Uint const &width, Uint const &height, Uint const &layers = 1,
+          TextureChannelType const &format = TextureChannelType::RGBA32F);
   /*
    * @brief: This function creates a opengl texture set.
    * @param: size: size of texture (width and height are the same and its a
    * power of 2)
    * @param: layers: number of layers in texture
+   * @param: format: internal format of texture
    */
-  Texture(TextureSize const &size, Uint const &layers = 1);
+  Texture(TextureSize const &size, Uint const &layers = 1,
+          TextureChannelType const &format = TextureChannelType::RGBA32F);
   ~Texture() override;
 
   /*
@@ -93,7 +121,7 @@ public:
    * @return: texture index
    */
   Uint const &GetTextureIndex(Str const &name) const {
-    return mTextures.at(name);
+    return mLayers->textures.at(name);
   }
 
   /*
@@ -110,24 +138,98 @@ public:
    * @brief: Getter for texture size.
    * @return: texture size
    */
-  Uint const &GetLayers() const { return mLayers; }
+  Uint const &GetLayers() const { return mLayers->layers; }
+  /*
+   * @brief: Getter for number of mip levels at full residency.
+   * @return: number of mip levels
+   */
+  Uint const &GetLevels() const { return mLevels; }
+  /*
+   * @brief: Getter for internal format.
+   * @return: internal format
+   */
+  TextureChannelType const &GetFormat() const { return mFormat; }
+  /*
+   * @brief: Getter for number of evicted top mip levels.
+   * @return: number of evicted mip levels
+   */
+  Uint const &GetEvictedLevels() const { return mLayers->evictedLevels; }
+  /*
+   * @brief: Getter for GPU memory held by texture.
+   * @return: size in bytes
+   */
+  Size GetByteSize() const;
   /*
    * @brief: Getter for current empty layer.
    * @return: current empty layer
+   * @detail: Released layers are reused before new layers are appended.
+   */
+  Uint GetCurrentLayer() const {
+    return mLayers->freeLayers.empty() ? mLayers->usedLayers
+                                       : mLayers->freeLayers.back();
+  }
+
+  /*
+   * @brief: Getter for sampler bound with texture.
+   * @return: sampler
    */
-  Uint GetCurrentLayer() const { return mTextures.size(); }
+  Sampler const &GetSampler() const { return mSampler; }
 
   /*
    * @brief: Setter for texture filter.
    * @param: min: min filter type
    * @param: mag: mag filter type
+   * @detail: Switches to cached sampler. Texture state is not touched.
    */
   void SetFilter(FilterType const &min, FilterType const &mag);
   /*
-   * @brief: Setter for texture filter.
-   * @param: filter: filter type
+   * @brief: Setter for texture wrapping.
+   * @param: s: wrapping type of s axis
+   * @param: t: wrapping type of t axis
+   * @detail: Switches to cached sampler. Texture state is not touched.
    */
   void SetWrapping(WrappingType const &s, WrappingType const &t);
+  /*
+   * @brief: Setter for sampler state bound with texture.
+   * @param: descriptor: sampler state
+   */
+  void SetSampler(SamplerDescriptor const &descriptor) {
+    mSampler = Sampler::Get(descriptor);
+  }
+
+  /*
+   * @brief: Acquires an empty layer, growing the texture array if needed.
+   * @return: acquired layer
+   */
+  Uint AcquireLayer();
+  /*
+   * @brief: Releases the layer bound to name into the free list.
+   * @param: name: name of texture
+   * @detail: The layer is reused once no other name is bound to it.
+   */
+  void ReleaseLayer(Str const &name);
+  /*
+   * @brief: Grows the texture array to hold at least the given layers.
+   * @param: layers: number of layers to hold
+   * @detail: Storage is reallocated and existing layers are copied on the
+   * GPU. The OpenGL texture ID changes, but every copy of this texture and
+   * every name to layer binding stays valid.
+   */
+  void Reserve(Uint const &layers);
+  /*
+   * @brief: Drops top mip levels to free GPU memory.
+   * @param: levels: number of levels to drop
+   * @detail: Remaining levels are kept on the GPU. Dropping every level
+   * releases the storage while name to layer bindings stay valid.
+   */
+  void Evict(Uint const &levels = 1u);
+  /*
+   * @brief: Reallocates storage dropped by Evict.
+   * @detail: Levels kept by Evict are copied back. Dropped levels are
+   * undefined until data is loaded again. Textures registered with a
+   * ResidencyManager are restored and reloaded by ResidencyManager::Touch.
+   */
+  void Restore();
 
   /*
    * @brief: Loads texture data into OpenGL texture.
@@ -136,6 +238,7 @@ public:
    * @param: height: height of texture
    * @param: channels: number of channels in texture
    * @param: data: pointer to texture data
+   * @detail: Throws if mip levels are evicted. Restore the texture first.
    */
   void LoadData(Str const &name, Uint width, Uint height, Uint channels,
                 Ubyte const *data);
@@ -158,6 +261,7 @@ public:
    * @param: height: height of texture
    * @param: channels: number of channels in texture
    * @param: data: pointer to texture data
+   * @detail: Throws if mip levels are evicted. Restore the texture first.
    */
   void LoadDataAt(Str const &name, Uint const &xoffset, Uint const &yoffset,
                   Uint const &layer, Uint const &width, Uint const &height,
@@ -175,21 +279,58 @@ public:
     this->LoadDataAt(name, xoffset, yoffset, layer, data.width, data.height,
                      data.channels, data.pixels.data());
   }
+  /*
+   * @brief: Loads many unnamed regions with one texture bind.
+   * @param: regions: regions to load
+   * @param: channels: number of channels of every region
+   * @detail: Layers are grown and marked as used like LoadDataAt. No name
+   * is bound, so atlases do not pay a map entry per region. Throws if mip
+   * levels are evicted.
+   */
+  void LoadRegions(Vec<TextureRegion> const &regions, Uint const &channels);
 
   /*
-   * @brief: Binds texture to OpenGL.
+   * @brief: Binds texture and its sampler to active texture unit.
+   */
+  void Bind() const {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, (TCu32)mTexture);
+    mSampler.Bind();
+  }
+  /*
+   * @brief: Binds texture to texture unit with given sampler.
+   * @param: target: texture unit
+   * @param: sampler: sampler to sample texture with
+   * @detail: Texture unit becomes active.
    */
-  void Bind() const { glBindTexture(GL_TEXTURE_2D_ARRAY, (TCu32)mTexture); }
+  void Bind(TextureTargets const &target, Sampler const &sampler) const;
   /*
-   * @brief: Unbinds texture from OpenGL.
+   * @brief: Unbinds texture and sampler from active texture unit.
    */
-  void Unbind() const { glBindTexture(GL_TEXTURE_2D_ARRAY, 0); }
+  void Unbind() const {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    Sampler::Unbind();
+  }
 
   Uint const &operator[](Str const &name) const {
     return this->GetTextureIndex(name);
   }
 
 public:
+  /*
+   * @brief: Allocates storage of texture bound to target.
+   * @param: target: GL_TEXTURE_2D_ARRAY, GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+   * @param: levels: number of mip levels
+   * @param: format: internal format
+   * @param: width: base level width
+   * @param: height: base level height
+   * @param: depth: number of layers (ignored for 2D and cube targets)
+   * @detail: Uses immutable storage when available, otherwise specifies
+   * every level with glTexImage and clamps the level range.
+   */
+  static void AllocateStorage(GLenum const &target, Uint const &levels,
+                              TextureChannelType const &format,
+                              Uint const &width, Uint const &height,
+                              Uint const &depth = 1);
   /*
    * @brief: Getter for maximum texture size.
    * @return: maximum texture size
@@ -205,6 +346,12 @@ public:
    * @return: maximum texture layers
    */
   static Uint GetMaxLayers();
+  /*
+   * @brief: Getter for size of one texel.
+   * @param: format: internal format of texture
+   * @return: size in bytes
+   */
+  static Uint GetTexelSize(TextureChannelType const &format);
 };
 
 class CubeTexture final : public TerreateObjectBase {
@@ -213,14 +360,31 @@ private:
   Uint mWidth = 0u;
   Uint mHeight = 0u;
   Uint mChannels = 0u;
-  FilterType mFilter = FilterType::LINEAR;
-  WrappingType mWrap = WrappingType::REPEAT;
+  Uint mLevels = 0u;
+  Uint mEvictedLevels = 0u;
+  TextureChannelType mFormat = TextureChannelType::RGBA8;
+  Sampler mSampler = Sampler::Get({FilterType::LINEAR_MIPMAP_LINEAR,
+                                   FilterType::LINEAR,
+                                   WrappingType::CLAMP_TO_EDGE,
+                                   WrappingType::CLAMP_TO_EDGE,
+                                   WrappingType::CLAMP_TO_EDGE});
+
+private:
+  void Allocate(Uint const &width, Uint const &height);
 
 public:
   /*
    * @brief: This function creates a opengl cube texture.
    */
   CubeTexture() { glGenTextures(1, mTexture); }
+  /*
+   * @brief: This function creates a opengl cube texture with immutable
+   * storage and full mip chain.
+   * @param: size: width and height of each face
+   * @param: format: internal format of texture
+   */
+  CubeTexture(Uint const &size,
+              TextureChannelType const &format = TextureChannelType::RGBA8);
   /*
    * @brief: DO NOT USE THIS CONSTRUCTOR.
    * This constructor should only be created by CubeScreen.
@@ -231,20 +395,75 @@ public:
    */
   CubeTexture(Uint const &texture, Uint const &width, Uint const &height,
               Uint const &channels)
-      : mTexture(texture), mWidth(width), mHeight(height), mChannels(channels) {
-  }
+      : mTexture(texture), mWidth(width), mHeight(height), mChannels(channels),
+        mLevels(1u) {}
   ~CubeTexture() override;
 
+  /*
+   * @brief: Getter for OpenGL texture ID.
+   * @return: OpenGL texture ID
+   */
+  Uint const &GetGLIndex() const { return mTexture; }
+  /*
+   * @brief: Getter for face width.
+   * @return: face width
+   */
+  Uint const &GetWidth() const { return mWidth; }
+  /*
+   * @brief: Getter for face height.
+   * @return: face height
+   */
+  Uint const &GetHeight() const { return mHeight; }
+  /*
+   * @brief: Getter for number of mip levels.
+   * @return: number of mip levels
+   */
+  Uint const &GetLevels() const { return mLevels; }
+  /*
+   * @brief: Getter for number of evicted top mip levels.
+   * @return: number of evicted mip levels
+   */
+  Uint const &GetEvictedLevels() const { return mEvictedLevels; }
+  /*
+   * @brief: Getter for GPU memory held by texture.
+   * @return: size in bytes
+   */
+  Size GetByteSize() const;
+  /*
+   * @brief: Getter for internal format.
+   * @return: internal format
+   */
+  TextureChannelType const &GetFormat() const { return mFormat; }
+  /*
+   * @brief: Getter for sampler bound with texture.
+   * @return: sampler
+   */
+  Sampler const &GetSampler() const { return mSampler; }
+
   /*
    * @brief: Setter for texture filter.
    * @param: filter: filter type
+   * @detail: Mipmap filters are only applied to minification.
    */
   void SetFilter(FilterType const &filter);
+  /*
+   * @brief: Setter for texture filter.
+   * @param: min: min filter type
+   * @param: mag: mag filter type
+   */
+  void SetFilter(FilterType const &min, FilterType const &mag);
   /*
    * @brief: Setter for texture wrapping.
    * @param: wrap: wrapping type
    */
   void SetWrapping(WrappingType const &wrap);
+  /*
+   * @brief: Setter for sampler state bound with texture.
+   * @param: descriptor: sampler state
+   */
+  void SetSampler(SamplerDescriptor const &descriptor) {
+    mSampler = Sampler::Get(descriptor);
+  }
 
   /*
    * @brief: Loads texture data into OpenGL texture.
@@ -253,6 +472,9 @@ public:
    * @param: height: height of texture
    * @param: channels: number of channels in texture
    * @param: data: pointer to texture data
+   * @detail: Storage is allocated by the first face. Call GenerateMipmaps
+   * after every face is loaded. Throws if mip levels are evicted and the
+   * face size is unchanged.
    */
   void LoadData(CubeFace face, Uint width, Uint height, Uint channels,
                 Ubyte const *data);
@@ -269,20 +491,59 @@ public:
    * @brief: Loads texture data into OpenGL texture.
    * @param: datas: texture data
    * @detail: datas should be in the order of
-   * {right, left, top, bottom, front, back}
+   * {right, left, top, bottom, front, back}. Mipmaps are generated once
+   * after every face is loaded.
    */
   void LoadDatas(Vec<TextureData> const &datas);
+  /*
+   * @brief: Generates mip chain from base level.
+   */
+  void GenerateMipmaps() const;
+  /*
+   * @brief: Drops top mip levels to free GPU memory.
+   * @param: levels: number of levels to drop
+   * @detail: Dropping every level releases the storage.
+   */
+  void Evict(Uint const &levels = 1u);
+  /*
+   * @brief: Reallocates storage dropped by Evict.
+   * @detail: Levels kept by Evict are copied back. Dropped levels are
+   * undefined until data is loaded again. Textures registered with a
+   * ResidencyManager are restored and reloaded by ResidencyManager::Touch.
+   */
+  void Restore();
 
   /*
-   * @brief: Binds texture to OpenGL.
+   * @brief: Binds texture and its sampler to active texture unit.
+   */
+  void Bind() const {
+    glBindTexture(GL_TEXTURE_CUBE_MAP, mTexture);
+    mSampler.Bind();
+  }
+  /*
+   * @brief: Binds texture to texture unit with given sampler.
+   * @param: target: texture unit
+   * @param: sampler: sampler to sample texture with
+   * @detail: Texture unit becomes active.
    */
-  void Bind() const { glBindTexture(GL_TEXTURE_CUBE_MAP, mTexture); }
+  void Bind(TextureTargets const &target, Sampler const &sampler) const;
   /*
-   * @brief: Unbinds texture from OpenGL.
+   * @brief: Unbinds texture and sampler from active texture unit.
    */
-  void Unbind() const { glBindTexture(GL_TEXTURE_CUBE_MAP, 0); }
+  void Unbind() const {
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    Sampler::Unbind();
+  }
 
   operator Bool() const override { return mTexture; }
+
+public:
+  /*
+   * @brief: Getter for number of mip levels in full mip chain.
+   * @param: size: size of base level
+   * @return: number of mip levels
+   */
+  static Uint GetMipLevels(Uint const &size);
 };
 } // namespace TerreateGraphics::Core
 
@@ -0,0 +1,61 @@
+#ifndef __TERREATE_GRAPHICS_UNICODE_HPP__
+#define __TERREATE_GRAPHICS_UNICODE_HPP__
+
+#include "defines.hpp"
+
+namespace TerreateGraphics::Core {
+using namespace TerreateGraphics::Defines;
+
+namespace Unicode {
+// Codepoint substituted for invalid input.
+static Uint const sReplacementCharacter = 0xFFFDu;
+
+/*
+ * @brief: Decodes one codepoint from UTF-8.
+ * @param: src: UTF-8 bytes
+ * @param: size: number of bytes available, at least 1
+ * @param: codepoint: decoded codepoint
+ * @param: length: number of bytes consumed, at least 1
+ * @return: false if bytes are not valid UTF-8
+ * @detail: Overlong forms, surrogates, codepoints above U+10FFFF and
+ * truncated sequences are invalid. They decode to U+FFFD and consume the
+ * lead byte plus the continuation bytes that were valid, so decoding
+ * resynchronizes on the next lead byte.
+ */
+Bool DecodeCodepoint(char const *src, Size const &size, Uint &codepoint,
+                     Size &length);
+/*
+ * @brief: Decodes UTF-8 into codepoints.
+ * @param: src: UTF-8 bytes
+ * @param: size: number of bytes
+ * @param: dst: string to write one codepoint per character into
+ * @return: false if input had invalid sequences
+ * @detail: Runs of ASCII are widened 16 bytes at a time. dst is
+ * overwritten but keeps its capacity, so decoding into the same string
+ * allocates nothing in steady state. Where wchar_t has 16 bits,
+ * codepoints above U+FFFF decode to U+FFFD.
+ */
+Bool DecodeUTF8(char const *src, Size const &size, WStr &dst);
+/*
+ * @brief: Decodes UTF-8 into codepoints.
+ * @param: src: UTF-8 string
+ * @param: dst: string to write one codepoint per character into
+ * @return: false if input had invalid sequences
+ */
+inline Bool DecodeUTF8(Str const &src, WStr &dst) {
+  return DecodeUTF8(src.data(), src.size(), dst);
+}
+/*
+ * @brief: Decodes UTF-8 into codepoints.
+ * @param: src: UTF-8 string
+ * @return: decoded string
+ */
+inline WStr DecodeUTF8(Str const &src) {
+  WStr dst;
+  DecodeUTF8(src, dst);
+  return dst;
+}
+} // namespace Unicode
+} // namespace TerreateGraphics::Core
+
+#endif // __TERREATE_GRAPHICS_UNICODE_HPP__
@@ -23,8 +23,8 @@ struct Settings {
   vec4 setting;
 };
 
-void OutputJoystickData(Joystick const &joystick, Text &text, Uint const &width,
-                        Uint const &height) {
+void OutputJoystickData(Joystick const &joystick, TextBatch &batch,
+                        Font *font) {
   JoystickAxisState axisState = joystick.AcquireAxisState();
   JoystickButtonState buttonState = joystick.AcquireButtonState();
   JoystickHatState hatState = joystick.AcquireHatState();
@@ -38,13 +38,11 @@ void OutputJoystickData(Joystick const &joystick, Text &text, Uint const &width,
 
   if (!joystick.IsConnected()) {
     ss << " Disconnected";
-    text.LoadText(ss.str());
-    text.Render(0, 1500, width, height);
+    batch.Submit(ss.str(), font, 0, 1500, vec3(1.0f), 32);
     return;
   } else {
     ss << " Connected";
-    text.LoadText(ss.str());
-    text.Render(0, 1500, width, height);
+    batch.Submit(ss.str(), font, 0, 1500, vec3(1.0f), 32);
   }
 
   ss.str("");
@@ -55,8 +53,7 @@ void OutputJoystickData(Joystick const &joystick, Text &text, Uint const &width,
   ss << std::fixed << std::setprecision(3)
      << " / Left Trigger: " << axisState.leftTrigger
      << " / Right Trigger: " << axisState.rightTrigger;
-  text.LoadText(ss.str());
-  text.Render(0, 1450, width, height);
+  batch.Submit(ss.str(), font, 0, 1450, vec3(1.0f), 32);
 
   ss.str("");
   ss << "A: " << buttonState.a << " / B: " << buttonState.b
@@ -64,8 +61,7 @@ void OutputJoystickData(Joystick const &joystick, Text &text, Uint const &width,
   ss << " / Cross: " << buttonState.cross << " / Circle: " << buttonState.circle
      << " / Square: " << buttonState.square
      << " / Triangle: " << buttonState.triangle;
-  text.LoadText(ss.str());
-  text.Render(0, 1400, width, height);
+  batch.Submit(ss.str(), font, 0, 1400, vec3(1.0f), 32);
 
   ss.str("");
   ss << "Left Bumper: " << buttonState.leftBumper
@@ -74,22 +70,19 @@ void OutputJoystickData(Joystick const &joystick, Text &text, Uint const &width,
      << " / Guide: " << buttonState.guide
      << " / Left Thumb: " << buttonState.leftThumb
      << " / Right Thumb: " << buttonState.rightThumb;
-  text.LoadText(ss.str());
-  text.Render(0, 1350, width, height);
+  batch.Submit(ss.str(), font, 0, 1350, vec3(1.0f), 32);
 
   ss.str("");
   ss << "D-Pad: Up: " << buttonState.dpadUp
      << " / Right: " << buttonState.dpadRight
      << " / Down: " << buttonState.dpadDown
      << " / Left: " << buttonState.dpadLeft;
-  text.LoadText(ss.str());
-  text.Render(0, 1300, width, height);
+  batch.Submit(ss.str(), font, 0, 1300, vec3(1.0f), 32);
 
   ss.str("");
   ss << "Hat: Up: " << hatState.up << " / Right: " << hatState.right
      << " / Down: " << hatState.down << " / Left: " << hatState.left;
-  text.LoadText(ss.str());
-  text.Render(0, 1250, width, height);
+  batch.Submit(ss.str(), font, 0, 1250, vec3(1.0f), 32);
 }
 
 class TestApp {
@@ -107,8 +100,8 @@ private:
   Font mFont;
   Text mText;
 
-  Font mInfoFont;
-  Text mInfoText;
+  TextBatch mBatch;
+  TextLayoutCache mLayouts;
 
   Texture mTexture;
   Texture mTexture2;
@@ -167,16 +160,15 @@ public:
 
 public:
   TestApp() : mScreen(1000, 1000, 4) {
-    mFont = Font("tests/resources/AsebiMin-Light.otf", 128);
-    mInfoFont = Font("tests/resources/AsebiMin-Light.otf", 32);
+    mFont = Font("tests/resources/AsebiMin-Light.otf", 128, 256,
+                 FontRenderMode::SDF);
 
     mText.LoadFont(&mFont);
     mText.LoadShader("tests/resources/shaders/textVert.glsl",
-                     "tests/resources/shaders/textFrag.glsl");
+                     "tests/resources/shaders/textSDFFrag.glsl");
 
-    mInfoText.LoadFont(&mInfoFont);
-    mInfoText.LoadShader("tests/resources/shaders/textVert.glsl",
-                         "tests/resources/shaders/textFrag.glsl");
+    mBatch.LoadShader("tests/resources/shaders/textBatchVert.glsl",
+                      "tests/resources/shaders/textBatchSDFFrag.glsl");
 
     mShader.AddVertexShaderSource(
         Shader::LoadShaderSource("tests/resources/shaders/mainVert.glsl"));
@@ -336,11 +328,25 @@ public:
     /* mBuffer.ReloadData(color, mColorDataConstructor); */
     mText.SetColor({1, 0, 0});
 
-    mInfoText = L"FPS: " + std::to_wstring(mClock.GetFPS());
-    mInfoText.Render(0, 180, mWidth, mHeight);
+    mBatch.Submit(L"FPS: " + std::to_wstring(mClock.GetFPS()), &mFont, 0,
+                  180, vec3(1.0f), 32);
 
     Joystick const &joystick = Joystick::GetJoystick(JoystickID::JOYSTICK1);
-    OutputJoystickData(joystick, mInfoText, mWidth, mHeight);
+    OutputJoystickData(joystick, mBatch, &mFont);
+
+    TextLayoutSettings tooltip;
+    tooltip.maxWidth = 400.0f;
+    tooltip.alignment = TextAlignment::CENTER;
+    mBatch.Submit(mLayouts.Acquire(&mFont,
+                                   {{L"Type to edit the text. ", vec3(1.0f),
+                                     24.0f},
+                                    {L"Backspace", vec3(1.0f, 0.8f, 0.2f),
+                                     24.0f},
+                                    {L" deletes the last character.",
+                                     vec3(1.0f), 24.0f}},
+                                   tooltip),
+                  mWidth - 420.0f, mHeight - 20.0f);
+    mBatch.Flush(mWidth, mHeight);
 
     window->Swap();
     ++mDelflag;
@@ -392,6 +398,47 @@ void TestCompute() {
   }
 }
 
+void TestResample() {
+  TextureData source;
+  source.width = 37;
+  source.height = 23;
+  source.channels = 4;
+  for (Uint i = 0; i < source.width * source.height * 4; ++i) {
+    source.pixels.push_back((Ubyte)((i * 73 + (i >> 3) * 29) & 0xFF));
+  }
+
+  ImageConverter converter;
+  Vec<ResampleFilter> filters = {ResampleFilter::BOX,
+                                 ResampleFilter::TRIANGLE,
+                                 ResampleFilter::MITCHELL,
+                                 ResampleFilter::LANCZOS3};
+  Vec<Pair<Uint>> sizes = {{17, 11}, {80, 61}};
+  for (auto const &filter : filters) {
+    for (auto const &[width, height] : sizes) {
+      converter.SetFilter(filter);
+      Texture storage(width, height, 1, TextureChannelType::RGBA8);
+      converter.Convert("test", source.width, source.height, source.channels,
+                        source.pixels.data(), storage);
+
+      Vec<Ubyte> gpu(width * height * 4);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, storage.GetGLIndex());
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                    gpu.data());
+      glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+      TextureData cpu = ImageOps::Resample(source, width, height, filter);
+      Uint mismatches = 0;
+      for (Uint i = 0; i < gpu.size(); ++i) {
+        mismatches += gpu[i] != cpu.pixels[i] ? 1 : 0;
+      }
+      std::cout << "resample filter " << (int)filter << " " << width << "x"
+                << height << ": " << mismatches << " mismatched bytes"
+                << std::endl;
+    }
+  }
+}
+
 int main() {
   Initialize();
   {
@@ -413,6 +460,7 @@ int main() {
         });
 
     // TestCompute();
+    TestResample();
 
     while (window) {
       window.Frame([&app](Window *window) { app.OnFrame(window); });
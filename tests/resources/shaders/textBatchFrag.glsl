@@ -0,0 +1,15 @@
+#version 430 core
+in vec3 vUV;
+in vec3 vColor;
+
+out vec4 fragColor;
+
+uniform sampler2DArray uTexture;
+
+void main() {
+  float alpha = texture(uTexture, vUV).r;
+  if (alpha < 0.1) {
+    discard;
+  }
+  fragColor = vec4(vColor, alpha);
+}
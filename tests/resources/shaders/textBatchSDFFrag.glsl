@@ -0,0 +1,18 @@
+#version 430 core
+in vec3 vUV;
+in vec3 vColor;
+
+out vec4 fragColor;
+
+uniform sampler2DArray uTexture;
+
+void main() {
+  // FreeType stores the outline at 128 and inside distances above it.
+  float distance = texture(uTexture, vUV).r - 128.0 / 255.0;
+  float width = max(fwidth(distance), 1e-4);
+  float alpha = clamp(distance / width + 0.5, 0.0, 1.0);
+  if (alpha <= 0.0) {
+    discard;
+  }
+  fragColor = vec4(vColor, alpha);
+}
@@ -0,0 +1,19 @@
+#version 430 core
+layout(location=0) in vec4 iRect;
+layout(location=1) in vec4 iUV;
+layout(location=2) in uint iLayer;
+layout(location=3) in vec4 iColor;
+
+out vec3 vUV;
+out vec3 vColor;
+
+uniform mat4 uTransform;
+
+void main() {
+  // Strip corners in order: bottom left, bottom right, top left, top right.
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  vec2 position = iRect.xy + corner * iRect.zw;
+  gl_Position = uTransform * vec4(position, 0.0f, 1.0f);
+  vUV = vec3(mix(iUV.xy, iUV.zw, corner), float(iLayer));
+  vColor = iColor.rgb;
+}